@@ -0,0 +1,80 @@
+#pragma once
+
+#include "particle.hpp"
+#include "common.hpp"
+#include <cstddef>
+#include <cstdint>
+
+// Binary snapshot of a full simulation: SoA arrays, planets and SimConfig.
+//
+// Layout (little-endian, every section starts on a 64-byte boundary):
+//   CheckpointHeader | SimConfig bytes | Planet records | posX | posY | velX | velY
+//
+// The arrays are stored exactly as they sit in memory, so a mapped file can be
+// read in place and a restore is one sequential copy per array.
+
+constexpr uint32_t CHECKPOINT_VERSION = 2;   // 2: SimConfig layout fingerprint
+constexpr uint64_t CHECKPOINT_ALIGN = 64;
+
+enum class CheckpointArray : int { PosX = 0, PosY, VelX, VelY, Count };
+
+struct CheckpointHeader {
+    char magic[8];              // "PSIMCKPT"
+    uint32_t version;
+    uint32_t headerSize;        // sizeof(CheckpointHeader)
+    uint32_t configSize;        // sizeof(SimConfig) of the writer
+    uint32_t planetRecordSize;  // sizeof(Planet) of the writer
+    uint64_t particleCount;
+    uint64_t planetCount;
+    uint64_t frame;             // Steps taken when saved
+    uint64_t configOffset;
+    uint64_t planetsOffset;
+    uint64_t arrayOffset[static_cast<int>(CheckpointArray::Count)];
+    uint64_t fileSize;
+    uint64_t configLayout;      // checkpointConfigLayout() of the writer (0 in version 1)
+    uint8_t reserved[16];
+};
+static_assert(sizeof(CheckpointHeader) == 128, "Header layout is part of the file format");
+
+// Fingerprint of SimConfig's field names, offsets and sizes
+uint64_t checkpointConfigLayout();
+
+// Streams the state to path (via a temporary file renamed into place)
+bool saveCheckpoint(const char* path, const ParticleSystem& particles, const SimConfig& config, uint64_t frame);
+
+// Read-only mapping of a checkpoint file. Array and planet accessors point
+// straight into the mapping and stay valid until close().
+class MappedCheckpoint {
+    public:
+        MappedCheckpoint() = default;
+        ~MappedCheckpoint();
+
+        MappedCheckpoint(const MappedCheckpoint&) = delete;
+        MappedCheckpoint& operator=(const MappedCheckpoint&) = delete;
+
+        bool open(const char* path);
+        void close();
+        bool isOpen() const { return data != nullptr; }
+
+        const CheckpointHeader& header() const { return *reinterpret_cast<const CheckpointHeader*>(data); }
+        int particleCount() const { return static_cast<int>(header().particleCount); }
+        uint64_t frame() const { return header().frame; }
+
+        const float* array(CheckpointArray which) const;
+        const Planet* planets() const;
+        int planetCount() const { return static_cast<int>(header().planetCount); }
+
+        // False when the file was written by a build with a different SimConfig
+        // layout (or by version 1, which did not record it)
+        bool hasConfig() const {
+            return header().configSize == sizeof(SimConfig) && header().configLayout == checkpointConfigLayout();
+        }
+
+        // Copies the arrays into particles. config is replaced when hasConfig(),
+        // otherwise only its particleCount is updated.
+        void restore(ParticleSystem& particles, SimConfig& config) const;
+
+    private:
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+};
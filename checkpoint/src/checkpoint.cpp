@@ -0,0 +1,267 @@
+#include "checkpoint.hpp"
+#include <cerrno>
+#include <cstddef>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Arrays and records are written as raw memory, which is only the declared
+// format on little-endian hosts
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "Checkpoint format assumes a little-endian host");
+static_assert(std::is_trivially_copyable<SimConfig>::value, "SimConfig is stored as raw bytes");
+static_assert(std::is_trivially_copyable<Planet>::value, "Planets are stored as raw records");
+
+namespace {
+    const char MAGIC[8] = { 'P', 'S', 'I', 'M', 'C', 'K', 'P', 'T' };
+
+    uint64_t alignUp(uint64_t value) {
+        return (value + CHECKPOINT_ALIGN - 1) & ~(CHECKPOINT_ALIGN - 1);
+    }
+
+    // write() until everything is out; large arrays go in one call per section
+    bool writeAll(int fd, const void* src, uint64_t bytes) {
+        const uint8_t* p = static_cast<const uint8_t*>(src);
+        while (bytes > 0) {
+            ssize_t n = ::write(fd, p, bytes);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            p += n;
+            bytes -= static_cast<uint64_t>(n);
+        }
+        return true;
+    }
+
+    bool writeSection(int fd, uint64_t& offset, const void* src, uint64_t bytes) {
+        static const uint8_t zeros[CHECKPOINT_ALIGN] = {};
+        if (!writeAll(fd, src, bytes)) return false;
+        uint64_t padded = alignUp(offset + bytes);
+        if (!writeAll(fd, zeros, padded - offset - bytes)) return false;
+        offset = padded;
+        return true;
+    }
+
+    // --- SimConfig layout ---
+    struct ConfigField {
+        const char* name;
+        size_t offset, size, align;
+    };
+
+#define CHECKPOINT_CONFIG_FIELD(f) { #f, offsetof(SimConfig, f), sizeof(SimConfig::f), alignof(decltype(SimConfig::f)) },
+    constexpr ConfigField CONFIG_FIELDS[] = { SIM_CONFIG_FIELDS(CHECKPOINT_CONFIG_FIELD) };
+#undef CHECKPOINT_CONFIG_FIELD
+
+    constexpr size_t alignTo(size_t value, size_t align) {
+        return (value + align - 1) / align * align;
+    }
+
+    // Each field must start where the previous one ends (plus padding) and the
+    // last must end the struct, so a field missing from the list fails the
+    // build unless it hides entirely in padding
+    constexpr bool fieldsCoverConfig() {
+        size_t end = 0;
+        for (const ConfigField& f : CONFIG_FIELDS) {
+            if (f.offset != alignTo(end, f.align)) return false;
+            end = f.offset + f.size;
+        }
+        return alignTo(end, alignof(SimConfig)) == sizeof(SimConfig);
+    }
+    static_assert(fieldsCoverConfig(), "SIM_CONFIG_FIELDS must list every SimConfig field in declaration order");
+
+    // FNV-1a over names, offsets and sizes
+    constexpr uint64_t hashConfigLayout() {
+        uint64_t hash = 14695981039346656037ull;
+        for (const ConfigField& f : CONFIG_FIELDS) {
+            for (const char* c = f.name; *c; ++c) hash = (hash ^ static_cast<uint8_t>(*c)) * 1099511628211ull;
+            for (int shift = 0; shift < 64; shift += 8) hash = (hash ^ ((f.offset >> shift) & 0xff)) * 1099511628211ull;
+            for (int shift = 0; shift < 64; shift += 8) hash = (hash ^ ((f.size >> shift) & 0xff)) * 1099511628211ull;
+        }
+        return hash;
+    }
+    constexpr uint64_t CONFIG_LAYOUT = hashConfigLayout();
+
+    // Input events must not replay when a checkpoint is restored
+    void clearEvents(SimConfig& config) {
+        config.spawnClick = false;
+        config.saveCheckpoint = false;
+        config.loadCheckpoint = false;
+    }
+
+    // [offset, offset + length) lies inside the file; written so neither side can wrap
+    bool sectionFits(uint64_t offset, uint64_t length, uint64_t fileSize) {
+        return offset <= fileSize && length <= fileSize - offset;
+    }
+}
+
+uint64_t checkpointConfigLayout() {
+    return CONFIG_LAYOUT;
+}
+
+bool saveCheckpoint(const char* path, const ParticleSystem& particles, const SimConfig& config, uint64_t frame) {
+    uint64_t count = particles.posX.size();
+    const std::vector<float>* arrays[] = { &particles.posX, &particles.posY, &particles.velX, &particles.velY };
+    for (const std::vector<float>* arr : arrays) {
+        if (arr->size() != count) {
+            std::cerr << "[Checkpoint] Particle arrays have mismatched sizes" << std::endl;
+            return false;
+        }
+    }
+
+    // 1. Layout
+    CheckpointHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = CHECKPOINT_VERSION;
+    header.headerSize = sizeof(CheckpointHeader);
+    header.configSize = sizeof(SimConfig);
+    header.planetRecordSize = sizeof(Planet);
+    header.particleCount = count;
+    header.planetCount = particles.planets.size();
+    header.frame = frame;
+    header.configLayout = CONFIG_LAYOUT;
+
+    uint64_t offset = alignUp(sizeof(CheckpointHeader));
+    header.configOffset = offset;
+    offset = alignUp(offset + sizeof(SimConfig));
+    header.planetsOffset = offset;
+    offset = alignUp(offset + header.planetCount * sizeof(Planet));
+    for (int a = 0; a < static_cast<int>(CheckpointArray::Count); ++a) {
+        header.arrayOffset[a] = offset;
+        offset = alignUp(offset + count * sizeof(float));
+    }
+    header.fileSize = offset;
+
+    // 2. Stream every section, then publish the file atomically
+    std::string tmpPath = std::string(path) + ".tmp";
+    int fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        std::cerr << "[Checkpoint] Cannot create " << tmpPath << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    SimConfig stored = config;
+    clearEvents(stored);
+
+    // Planets live in SoA form; the file keeps whole records
+    std::vector<Planet> planetRecords(header.planetCount);
+    for (size_t i = 0; i < planetRecords.size(); ++i) planetRecords[i] = particles.planets.get(i);
+
+    uint64_t written = 0;
+    bool ok = writeSection(fd, written, &header, sizeof(header)) &&
+              writeSection(fd, written, &stored, sizeof(stored)) &&
+              writeSection(fd, written, planetRecords.data(), header.planetCount * sizeof(Planet));
+    for (const std::vector<float>* arr : arrays) {
+        ok = ok && writeSection(fd, written, arr->data(), count * sizeof(float));
+    }
+
+    if (::close(fd) != 0) ok = false;
+    if (!ok || std::rename(tmpPath.c_str(), path) != 0) {
+        std::cerr << "[Checkpoint] Failed to write " << path << ": " << std::strerror(errno) << std::endl;
+        std::remove(tmpPath.c_str());
+        return false;
+    }
+
+    std::cout << "[Checkpoint] Saved " << count << " particles (frame " << frame << ") to " << path << std::endl;
+    return true;
+}
+
+MappedCheckpoint::~MappedCheckpoint() {
+    close();
+}
+
+bool MappedCheckpoint::open(const char* path) {
+    close();
+
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "[Checkpoint] Cannot open " << path << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<uint64_t>(st.st_size) < sizeof(CheckpointHeader)) {
+        std::cerr << "[Checkpoint] " << path << " is too small to be a checkpoint" << std::endl;
+        ::close(fd);
+        return false;
+    }
+
+    size_t length = static_cast<size_t>(st.st_size);
+    void* mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // The mapping keeps the file alive
+    if (mapped == MAP_FAILED) {
+        std::cerr << "[Checkpoint] mmap failed for " << path << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    data = static_cast<const uint8_t*>(mapped);
+    size = length;
+
+    // Validate before anyone dereferences an offset
+    const CheckpointHeader& h = header();
+    const char* problem = nullptr;
+    if (std::memcmp(h.magic, MAGIC, sizeof(MAGIC)) != 0) problem = "bad magic";
+    else if (h.version < 1 || h.version > CHECKPOINT_VERSION) problem = "unsupported version";
+    else if (h.headerSize != sizeof(CheckpointHeader) || h.planetRecordSize != sizeof(Planet)) problem = "incompatible record layout";
+    else if (h.fileSize != size) problem = "truncated or padded file";
+    else if (h.particleCount > INT_MAX || h.planetCount > INT_MAX) problem = "count out of range";
+    else if (h.configOffset % CHECKPOINT_ALIGN || !sectionFits(h.configOffset, h.configSize, size)) problem = "config out of bounds";
+    else if (h.planetsOffset % CHECKPOINT_ALIGN || !sectionFits(h.planetsOffset, h.planetCount * sizeof(Planet), size)) problem = "planets out of bounds";
+    // Counts are bounded by INT_MAX above, so the section lengths cannot overflow
+    for (int a = 0; !problem && a < static_cast<int>(CheckpointArray::Count); ++a) {
+        if (h.arrayOffset[a] % CHECKPOINT_ALIGN || !sectionFits(h.arrayOffset[a], h.particleCount * sizeof(float), size)) {
+            problem = "array out of bounds";
+        }
+    }
+    if (problem) {
+        std::cerr << "[Checkpoint] Rejected " << path << ": " << problem << std::endl;
+        close();
+        return false;
+    }
+
+    // Restores and readers walk the arrays front to back
+    madvise(mapped, size, MADV_SEQUENTIAL);
+    return true;
+}
+
+void MappedCheckpoint::close() {
+    if (data) munmap(const_cast<uint8_t*>(data), size);
+    data = nullptr;
+    size = 0;
+}
+
+const float* MappedCheckpoint::array(CheckpointArray which) const {
+    return reinterpret_cast<const float*>(data + header().arrayOffset[static_cast<int>(which)]);
+}
+
+const Planet* MappedCheckpoint::planets() const {
+    return reinterpret_cast<const Planet*>(data + header().planetsOffset);
+}
+
+void MappedCheckpoint::restore(ParticleSystem& particles, SimConfig& config) const {
+    int count = particleCount();
+    std::vector<float>* arrays[] = { &particles.posX, &particles.posY, &particles.velX, &particles.velY };
+    for (int a = 0; a < static_cast<int>(CheckpointArray::Count); ++a) {
+        const float* src = array(static_cast<CheckpointArray>(a));
+        arrays[a]->assign(src, src + count);
+    }
+    const Planet* records = planets();
+    particles.planets.clear();
+    for (int i = 0; i < planetCount(); ++i) particles.planets.push_back(records[i]);
+
+    if (hasConfig()) {
+        std::memcpy(&config, data + header().configOffset, sizeof(SimConfig));
+        clearEvents(config);
+    } else {
+        std::cerr << "[Checkpoint] Settings were saved by a build with a different SimConfig layout"
+                  << (header().version < 2 ? " (version 1 file)" : "") << "; particles restored, current settings kept" << std::endl;
+    }
+    config.particleCount = count;
+}
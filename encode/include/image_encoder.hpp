@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+// Encoders for ARGB8888 frames as produced by the rasterizer. Each call works
+// on its own output buffer, so frames can be encoded on any number of threads.
+
+// --- Y4M (YUV 4:2:0, full-range BT.601; width and height must be even) ---
+bool writeY4mHeader(FILE* out, int width, int height, int fps);
+void convertToYuv420(const uint32_t* argb, int width, int height, std::vector<uint8_t>& yuv);
+bool writeY4mFrame(FILE* out, const std::vector<uint8_t>& yuv);
+
+// --- PNG (8-bit RGB) ---
+// Deflate uses fixed Huffman codes with one-pixel-back matches only: a
+// run-length coder that is fast and shrinks the mostly-black frames well
+// without pulling in zlib.
+void encodePng(const uint32_t* argb, int width, int height, std::vector<uint8_t>& png);
+bool writeFile(const char* path, const std::vector<uint8_t>& data);
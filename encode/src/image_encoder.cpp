@@ -0,0 +1,220 @@
+#include "image_encoder.hpp"
+#include <algorithm>
+
+namespace {
+    // --- Checksums ---
+    struct Crc32Table {
+        uint32_t entries[256];
+        Crc32Table() {
+            for (uint32_t n = 0; n < 256; ++n) {
+                uint32_t c = n;
+                for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                entries[n] = c;
+            }
+        }
+    };
+
+    uint32_t crc32(const uint8_t* data, size_t length, uint32_t crc = 0) {
+        static const Crc32Table table;
+        crc = ~crc;
+        for (size_t i = 0; i < length; ++i) crc = table.entries[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+        return ~crc;
+    }
+
+    uint32_t adler32(const uint8_t* data, size_t length) {
+        const uint32_t MOD = 65521;
+        uint32_t a = 1, b = 0;
+        while (length > 0) {
+            size_t block = std::min<size_t>(length, 5552); // Largest run without overflow
+            for (size_t i = 0; i < block; ++i) {
+                a += data[i];
+                b += a;
+            }
+            a %= MOD;
+            b %= MOD;
+            data += block;
+            length -= block;
+        }
+        return (b << 16) | a;
+    }
+
+    void putBigEndian(std::vector<uint8_t>& out, uint32_t v) {
+        out.push_back(static_cast<uint8_t>(v >> 24));
+        out.push_back(static_cast<uint8_t>(v >> 16));
+        out.push_back(static_cast<uint8_t>(v >> 8));
+        out.push_back(static_cast<uint8_t>(v));
+    }
+
+    // --- Deflate (fixed Huffman) ---
+    class BitWriter {
+        public:
+            explicit BitWriter(std::vector<uint8_t>& out) : out(out) {}
+
+            void bits(uint32_t value, int count) {
+                acc |= static_cast<uint64_t>(value) << used;
+                used += count;
+                while (used >= 8) {
+                    out.push_back(static_cast<uint8_t>(acc));
+                    acc >>= 8;
+                    used -= 8;
+                }
+            }
+
+            // Huffman codes go out most significant bit first
+            void code(uint32_t value, int count) {
+                uint32_t reversed = 0;
+                for (int i = 0; i < count; ++i) reversed |= ((value >> i) & 1u) << (count - 1 - i);
+                bits(reversed, count);
+            }
+
+            void flush() {
+                if (used > 0) out.push_back(static_cast<uint8_t>(acc));
+                acc = 0;
+                used = 0;
+            }
+
+        private:
+            std::vector<uint8_t>& out;
+            uint64_t acc = 0;
+            int used = 0;
+    };
+
+    void literal(BitWriter& w, int value) {
+        if (value < 144) w.code(0x30 + value, 8);
+        else w.code(0x190 + (value - 144), 9);
+    }
+
+    void lengthSymbol(BitWriter& w, int symbol) {
+        if (symbol < 280) w.code(symbol - 256, 7);
+        else w.code(0xC0 + (symbol - 280), 8);
+    }
+
+    // Match of `length` (3..258) at distance `distance` (1..4: codes 0..3, no extra bits)
+    void match(BitWriter& w, int length, int distance) {
+        static const int BASE[] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                                    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+        static const int EXTRA[] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                                     3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+        int index = 28;
+        while (BASE[index] > length) index--;
+        lengthSymbol(w, 257 + index);
+        if (EXTRA[index] > 0) w.bits(length - BASE[index], EXTRA[index]);
+        w.code(distance - 1, 5);
+    }
+
+    void deflateRle(const uint8_t* data, size_t length, int period, std::vector<uint8_t>& out) {
+        BitWriter w(out);
+        w.bits(1, 1); // Final block
+        w.bits(1, 2); // Fixed Huffman
+
+        size_t i = 0;
+        while (i < length) {
+            size_t run = 0;
+            if (i >= static_cast<size_t>(period)) {
+                size_t limit = std::min<size_t>(258, length - i);
+                while (run < limit && data[i + run] == data[i + run - period]) run++;
+            }
+            if (run >= 3) {
+                match(w, static_cast<int>(run), period);
+                i += run;
+            } else {
+                literal(w, data[i]);
+                i++;
+            }
+        }
+        lengthSymbol(w, 256); // End of block
+        w.flush();
+    }
+
+    void pngChunk(std::vector<uint8_t>& png, const char type[4], const uint8_t* data, size_t length) {
+        putBigEndian(png, static_cast<uint32_t>(length));
+        size_t start = png.size();
+        png.insert(png.end(), type, type + 4);
+        png.insert(png.end(), data, data + length);
+        putBigEndian(png, crc32(png.data() + start, length + 4));
+    }
+}
+
+bool writeY4mHeader(FILE* out, int width, int height, int fps) {
+    return std::fprintf(out, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", width, height, fps) > 0;
+}
+
+void convertToYuv420(const uint32_t* argb, int width, int height, std::vector<uint8_t>& yuv) {
+    size_t lumaSize = static_cast<size_t>(width) * height;
+    size_t chromaSize = lumaSize / 4;
+    yuv.resize(lumaSize + 2 * chromaSize);
+    uint8_t* yPlane = yuv.data();
+    uint8_t* uPlane = yPlane + lumaSize;
+    uint8_t* vPlane = uPlane + chromaSize;
+
+    // 16.16 fixed-point BT.601 full range
+    for (int y = 0; y < height; y += 2) {
+        for (int x = 0; x < width; x += 2) {
+            int sumR = 0, sumG = 0, sumB = 0;
+            for (int dy = 0; dy < 2; ++dy) {
+                for (int dx = 0; dx < 2; ++dx) {
+                    size_t index = static_cast<size_t>(y + dy) * width + x + dx;
+                    uint32_t c = argb[index];
+                    int r = (c >> 16) & 0xFF, g = (c >> 8) & 0xFF, b = c & 0xFF;
+                    yPlane[index] = static_cast<uint8_t>((19595 * r + 38470 * g + 7471 * b + 32768) >> 16);
+                    sumR += r;
+                    sumG += g;
+                    sumB += b;
+                }
+            }
+            // Chroma of the 2x2 average (sums are 4x, folded into the shift)
+            int u = (-11059 * sumR - 21709 * sumG + 32768 * sumB + (1 << 17)) >> 18;
+            int v = (32768 * sumR - 27439 * sumG - 5329 * sumB + (1 << 17)) >> 18;
+            size_t chromaIndex = static_cast<size_t>(y / 2) * (width / 2) + x / 2;
+            uPlane[chromaIndex] = static_cast<uint8_t>(std::min(255, std::max(0, u + 128)));
+            vPlane[chromaIndex] = static_cast<uint8_t>(std::min(255, std::max(0, v + 128)));
+        }
+    }
+}
+
+bool writeY4mFrame(FILE* out, const std::vector<uint8_t>& yuv) {
+    static const char FRAME_TAG[] = "FRAME\n";
+    return std::fwrite(FRAME_TAG, 1, sizeof(FRAME_TAG) - 1, out) == sizeof(FRAME_TAG) - 1 &&
+           std::fwrite(yuv.data(), 1, yuv.size(), out) == yuv.size();
+}
+
+void encodePng(const uint32_t* argb, int width, int height, std::vector<uint8_t>& png) {
+    // 1. Raw scanlines: filter byte 0 (None) + RGB
+    size_t rowBytes = 1 + static_cast<size_t>(width) * 3;
+    std::vector<uint8_t> raw(rowBytes * height);
+    for (int y = 0; y < height; ++y) {
+        uint8_t* row = raw.data() + y * rowBytes;
+        const uint32_t* src = argb + static_cast<size_t>(y) * width;
+        *row++ = 0;
+        for (int x = 0; x < width; ++x) {
+            *row++ = static_cast<uint8_t>(src[x] >> 16);
+            *row++ = static_cast<uint8_t>(src[x] >> 8);
+            *row++ = static_cast<uint8_t>(src[x]);
+        }
+    }
+
+    // 2. zlib stream: header, deflate, Adler-32
+    std::vector<uint8_t> zlib = { 0x78, 0x01 };
+    deflateRle(raw.data(), raw.size(), 3, zlib);
+    putBigEndian(zlib, adler32(raw.data(), raw.size()));
+
+    // 3. Chunks
+    static const uint8_t SIGNATURE[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    png.assign(SIGNATURE, SIGNATURE + sizeof(SIGNATURE));
+
+    std::vector<uint8_t> ihdr;
+    putBigEndian(ihdr, static_cast<uint32_t>(width));
+    putBigEndian(ihdr, static_cast<uint32_t>(height));
+    ihdr.insert(ihdr.end(), { 8, 2, 0, 0, 0 }); // 8-bit, RGB, deflate, adaptive filters, no interlace
+    pngChunk(png, "IHDR", ihdr.data(), ihdr.size());
+    pngChunk(png, "IDAT", zlib.data(), zlib.size());
+    pngChunk(png, "IEND", nullptr, 0);
+}
+
+bool writeFile(const char* path, const std::vector<uint8_t>& data) {
+    FILE* f = std::fopen(path, "wb");
+    if (!f) return false;
+    bool ok = std::fwrite(data.data(), 1, data.size(), f) == data.size();
+    if (std::fclose(f) != 0) ok = false;
+    return ok;
+}
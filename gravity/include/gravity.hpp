@@ -0,0 +1,38 @@
+#pragma once
+
+#include <vector>
+
+// Barnes-Hut quadtree for asteroid self-gravity.
+// All asteroids carry unit mass, so a node's mass is simply its body count.
+class BarnesHutTree {
+    public:
+        // Rebuilds the tree from the SoA position arrays. The node pool keeps its
+        // capacity between builds, so steady-state rebuilds do not allocate.
+        void build(const float* posX, const float* posY, int count);
+
+        // Acceleration at (x, y) from every body in the tree (without G).
+        // theta is the opening angle: a node is treated as a point mass when
+        // size / distance < theta.
+        void computeAcceleration(float x, float y, float theta, float softeningSq,
+                                 float& ax, float& ay) const;
+
+        int nodeCount() const { return static_cast<int>(nodes.size()); }
+
+    private:
+        // Children of a node are allocated as 4 contiguous entries in the pool,
+        // so a single index addresses them. Node bounds are implicit: they are
+        // recomputed from the root square while descending.
+        struct Node {
+            float comX;      // Center of mass (running sum during build)
+            float comY;
+            float mass;
+            int firstChild;  // -1 for leaves
+        };
+
+        static constexpr int MAX_DEPTH = 24; // Coincident bodies are merged below this depth
+
+        std::vector<Node> nodes;
+        float rootCenterX = 0.0f;
+        float rootCenterY = 0.0f;
+        float rootSize = 0.0f;
+};
@@ -0,0 +1,117 @@
+#include "gravity.hpp"
+#include <cmath>
+#include <algorithm>
+
+void BarnesHutTree::build(const float* posX, const float* posY, int count) {
+    nodes.clear();
+    if (count <= 0) return;
+
+    // 1. Square root bounds around all bodies
+    float minX = posX[0], maxX = posX[0];
+    float minY = posY[0], maxY = posY[0];
+    for (int i = 1; i < count; ++i) {
+        minX = std::min(minX, posX[i]); maxX = std::max(maxX, posX[i]);
+        minY = std::min(minY, posY[i]); maxY = std::max(maxY, posY[i]);
+    }
+    rootSize = std::max(maxX - minX, maxY - minY) * 1.0001f + 1e-3f;
+    rootCenterX = (minX + maxX) * 0.5f;
+    rootCenterY = (minY + maxY) * 0.5f;
+
+    // A quadtree over N bodies needs roughly 2N nodes; avoid regrowth mid-build
+    nodes.reserve(static_cast<size_t>(count) * 2 + 4);
+    nodes.push_back({0.0f, 0.0f, 0.0f, -1});
+
+    // 2. Insert bodies. Internal nodes accumulate position sums on the way down.
+    for (int i = 0; i < count; ++i) {
+        float x = posX[i];
+        float y = posY[i];
+        float cx = rootCenterX;
+        float cy = rootCenterY;
+        float half = rootSize * 0.5f;
+        int node = 0;
+        int depth = 0;
+
+        while (true) {
+            if (nodes[node].firstChild >= 0) {
+                Node& n = nodes[node];
+                n.comX += x; n.comY += y; n.mass += 1.0f;
+
+                int q = (x >= cx ? 1 : 0) | (y >= cy ? 2 : 0);
+                half *= 0.5f;
+                cx += (q & 1) ? half : -half;
+                cy += (q & 2) ? half : -half;
+                node = n.firstChild + q;
+                ++depth;
+                continue;
+            }
+
+            Node& leaf = nodes[node];
+            if (leaf.mass == 0.0f) {
+                leaf.comX = x; leaf.comY = y; leaf.mass = 1.0f;
+                break;
+            }
+            if (depth >= MAX_DEPTH) {
+                leaf.comX += x; leaf.comY += y; leaf.mass += 1.0f;
+                break;
+            }
+
+            // Split an occupied leaf: push its single body one level down and
+            // retry the insertion with this node as an internal node.
+            float ox = leaf.comX;
+            float oy = leaf.comY;
+            int first = static_cast<int>(nodes.size());
+            nodes.resize(nodes.size() + 4, {0.0f, 0.0f, 0.0f, -1});
+
+            int oq = (ox >= cx ? 1 : 0) | (oy >= cy ? 2 : 0);
+            nodes[first + oq] = {ox, oy, 1.0f, -1};
+            nodes[node].firstChild = first;
+        }
+    }
+
+    // 3. Convert position sums into centers of mass
+    for (auto& n : nodes) {
+        if (n.mass > 0.0f) {
+            n.comX /= n.mass;
+            n.comY /= n.mass;
+        }
+    }
+}
+
+void BarnesHutTree::computeAcceleration(float x, float y, float theta, float softeningSq,
+                                        float& ax, float& ay) const {
+    ax = 0.0f;
+    ay = 0.0f;
+    if (nodes.empty()) return;
+
+    struct StackEntry { int node; float size; };
+    StackEntry stack[4 * MAX_DEPTH + 8];
+    int top = 0;
+    stack[top++] = {0, rootSize};
+
+    float thetaSq = theta * theta;
+
+    while (top > 0) {
+        StackEntry e = stack[--top];
+        const Node& n = nodes[e.node];
+        if (n.mass == 0.0f) continue;
+
+        float dx = n.comX - x;
+        float dy = n.comY - y;
+        float distSq = dx*dx + dy*dy;
+
+        // Far enough (or a leaf): treat as a point mass.
+        // Softening also makes a body's pull on itself vanish (dx = dy = 0).
+        if (n.firstChild < 0 || e.size * e.size < thetaSq * distSq) {
+            float r2 = distSq + softeningSq;
+            float invR = 1.0f / std::sqrt(r2);
+            float f = n.mass * invR * invR * invR;
+            ax += dx * f;
+            ay += dy * f;
+        } else {
+            float childSize = e.size * 0.5f;
+            for (int c = 0; c < 4; ++c) {
+                stack[top++] = {n.firstChild + c, childSize};
+            }
+        }
+    }
+}
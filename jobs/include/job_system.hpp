@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Work-stealing job system for data-parallel passes over particle ranges.
+// Each thread owns a deque: it pops its own work from the back and steals
+// from the front of the others. The calling thread participates as worker 0,
+// and parallelFor() returns only after every chunk has run (a barrier).
+class JobSystem {
+    public:
+        // threadCount includes the calling thread; 0 uses all hardware threads
+        explicit JobSystem(int threadCount = 0);
+        ~JobSystem();
+
+        JobSystem(const JobSystem&) = delete;
+        JobSystem& operator=(const JobSystem&) = delete;
+
+        void resize(int threadCount);
+        int threadCount() const { return static_cast<int>(queues.size()); }
+
+        // Calls fn(begin, end) over [0, count) in chunks of about `grain` items
+        template <typename Fn>
+        void parallelFor(int count, int grain, Fn&& fn) {
+            if (count <= 0) return;
+            if (queues.size() <= 1 || count <= grain) {
+                fn(0, count);
+                return;
+            }
+            using FnType = std::remove_reference_t<Fn>;
+            Batch batch;
+            batch.context = &fn;
+            batch.invoke = [](const void* ctx, int begin, int end) {
+                (*static_cast<FnType*>(const_cast<void*>(ctx)))(begin, end);
+            };
+            run(batch, count, grain);
+        }
+
+    private:
+        struct Batch {
+            const void* context = nullptr;
+            void (*invoke)(const void*, int, int) = nullptr;
+            std::atomic<int> remaining{0};
+        };
+
+        struct Task {
+            Batch* batch;
+            int begin;
+            int end;
+        };
+
+        struct WorkerQueue {
+            std::mutex mutex;
+            std::deque<Task> tasks;
+        };
+
+        void start(int threadCount);
+        void stop();
+        void run(Batch& batch, int count, int grain);
+        void workerLoop(int index);
+        bool tryRunTask(int index);
+        bool popTask(int index, Task& task);
+
+        std::vector<std::unique_ptr<WorkerQueue>> queues;
+        std::vector<std::thread> workers;
+
+        std::mutex wakeMutex;
+        std::condition_variable wakeCondition;
+        std::atomic<int> pendingTasks{0};
+        bool stopping = false;
+};
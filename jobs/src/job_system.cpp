@@ -0,0 +1,120 @@
+#include "job_system.hpp"
+#include <algorithm>
+
+JobSystem::JobSystem(int threadCount) {
+    start(threadCount);
+}
+
+JobSystem::~JobSystem() {
+    stop();
+}
+
+void JobSystem::resize(int threadCount) {
+    stop();
+    start(threadCount);
+}
+
+void JobSystem::start(int threadCount) {
+    if (threadCount <= 0) {
+        threadCount = static_cast<int>(std::thread::hardware_concurrency());
+    }
+    threadCount = std::max(1, threadCount);
+
+    stopping = false;
+    for (int i = 0; i < threadCount; ++i) {
+        queues.push_back(std::make_unique<WorkerQueue>());
+    }
+    // Queue 0 belongs to the calling thread
+    for (int i = 1; i < threadCount; ++i) {
+        workers.emplace_back(&JobSystem::workerLoop, this, i);
+    }
+}
+
+void JobSystem::stop() {
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        stopping = true;
+    }
+    wakeCondition.notify_all();
+    for (auto& t : workers) t.join();
+    workers.clear();
+    queues.clear();
+}
+
+void JobSystem::run(Batch& batch, int count, int grain) {
+    grain = std::max(1, grain);
+    int chunks = (count + grain - 1) / grain;
+    batch.remaining.store(chunks, std::memory_order_relaxed);
+
+    // Announce the work first so the count never goes negative while stealing
+    pendingTasks.fetch_add(chunks, std::memory_order_release);
+
+    // Deal contiguous chunks round-robin so every deque starts with work
+    int numQueues = static_cast<int>(queues.size());
+    for (int c = 0; c < chunks; ++c) {
+        int begin = c * grain;
+        int end = std::min(count, begin + grain);
+        WorkerQueue& q = *queues[c % numQueues];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        q.tasks.push_back({&batch, begin, end});
+    }
+
+    {
+        // Taking the lock orders the notify after any worker's predicate check
+        std::lock_guard<std::mutex> lock(wakeMutex);
+    }
+    wakeCondition.notify_all();
+
+    // The caller works too, then waits for stragglers (the barrier)
+    while (batch.remaining.load(std::memory_order_acquire) > 0) {
+        if (!tryRunTask(0)) std::this_thread::yield();
+    }
+}
+
+bool JobSystem::popTask(int index, Task& task) {
+    // Own queue: newest first (its chunks are still warm in cache)
+    {
+        WorkerQueue& own = *queues[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = own.tasks.back();
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+
+    // Steal the oldest chunk from another queue
+    int numQueues = static_cast<int>(queues.size());
+    for (int k = 1; k < numQueues; ++k) {
+        WorkerQueue& victim = *queues[(index + k) % numQueues];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = victim.tasks.front();
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+bool JobSystem::tryRunTask(int index) {
+    Task task;
+    if (!popTask(index, task)) return false;
+
+    pendingTasks.fetch_sub(1, std::memory_order_relaxed);
+    task.batch->invoke(task.batch->context, task.begin, task.end);
+    task.batch->remaining.fetch_sub(1, std::memory_order_release);
+    return true;
+}
+
+void JobSystem::workerLoop(int index) {
+    while (true) {
+        if (tryRunTask(index)) continue;
+
+        std::unique_lock<std::mutex> lock(wakeMutex);
+        wakeCondition.wait(lock, [this] {
+            return stopping || pendingTasks.load(std::memory_order_acquire) > 0;
+        });
+        if (stopping) return;
+    }
+}
@@ -2,8 +2,32 @@
 
 #include "particle.hpp"
 #include "common.hpp"
+#include "gravity.hpp"
+#include "spatial_grid.hpp"
+#include "spatial_hash.hpp"
+#include "job_system.hpp"
+#include "profiler.hpp"
+#include "simd_kernels.hpp"
+#include <array>
+#include <utility>
 #include <vector>
 
+// Planets gathered for one tile of asteroids, in SoA form for the SIMD kernels
+struct NearbyPlanets {
+    std::vector<int> index;
+    std::vector<float> x, y, mass, radiusSq;
+    PlanetBatch batch;
+};
+
+// Wall-clock seconds spent in each phase of step(), accumulated across calls
+struct PhaseTimings {
+    double forces = 0.0;
+    double integration = 0.0;
+    double collisions = 0.0;
+    double boundaries = 0.0;
+    double reorder = 0.0;
+};
+
 class ParticleKinematics {
     private:
         ParticleSystem& particles;
@@ -14,24 +38,184 @@ class ParticleKinematics {
         const float boxHeight = SIM_HEIGHT;
 
         // --- Spatial Grid Optimization ---
-        static constexpr float CELL_SIZE = 2.5f; 
-        int gridWidth;
-        int gridHeight;
-        std::vector<std::vector<int>> grid;
+        static constexpr float CELL_SIZE = 2.5f;            // Dense grid, used only by the Z-order reorder
+        static constexpr float MIN_COLLISION_CELL = 0.05f;  // Keeps tiny radii from exploding the cell count
+        SpatialGrid grid;
+        SpatialHash collisionHash;                          // Sparse cells of 2 * collisionRadius (+ skin)
+
+        // --- Verlet Pair List ---
+        // With SimConfig::verletSkin > 0, the hash is only built to list the
+        // pairs closer than 2 * collisionRadius + skin, grouped by color block
+        // like the hash's cells. Substeps resolve that list until some body
+        // has moved half the skin since the build.
+        struct CollisionPair { int i, j; };
+        std::vector<CollisionPair> pairList;
+        std::vector<int> pairBlockStart;      // Block b owns pairList[pairBlockStart[b] .. pairBlockStart[b + 1])
+        int pairColorStart[5] = {};           // Blocks of color k are [pairColorStart[k], pairColorStart[k + 1])
+        std::vector<float> pairRefX, pairRefY; // Positions at the last build
+        uint64_t pairListLayout = ~0ull;      // layoutVersion the list indexes (~0 = none)
+        float pairListCutoff = 0.0f;
+        uint64_t pairListBuilds = 0;
+
+        // --- Threading ---
+        static constexpr int PARALLEL_GRAIN = 4096; // Particles per job chunk
+        static constexpr int FUSED_BLOCK = 2048;    // Particles per fused substep block (32 KB of SoA)
+        static constexpr int COLOR_BLOCK = 4;       // Cells per side of a collision color block (>= 2)
+        JobSystem jobs;
+        int activeWorkerThreads = 0;
+
+        // --- Vector Kernels ---
+        const SimdKernels& simd;
+        static constexpr float STAR_SOFTENING_SQ = 5.0f;
+        std::vector<float> planetRadiusSq;
+        PlanetBatch planetBatch;                   // All planets, refreshed by updatePlanetBatch()
+
+        // --- Planet Influence Grid ---
+        // Planets only pull asteroids closer than PLANET_CUTOFF, so with many
+        // planets each tile of asteroids gathers just those in nearby cells
+        static constexpr float PLANET_CUTOFF = 20.0f;
+        static constexpr int PLANET_CULL_MIN = 16;     // Below this every tile takes all planets
+        static constexpr int PLANET_TILE = 256;        // Asteroids sharing one gathered list
+        static constexpr int PLANET_PAIR_GRAIN = 64;   // Planets per planet-planet job chunk
+        SpatialGrid planetGrid;                        // PLANET_CUTOFF cells
+        float planetReach = PLANET_CUTOFF;             // Cutoff or largest radius, plus a margin
+
+        // --- Memory Layout ---
+        uint64_t stepCount = 0;
+        uint64_t layoutVersion = 0;   // Bumped whenever particle indices are reassigned
+        std::vector<int> reorderScratch;
+        std::vector<float> floatScratch;
+
+        // --- Population ---
+        uint64_t beltGenerated = 0;           // Belt bodies drawn since init(); the next one's RNG counter
+        std::vector<uint8_t> accreted;        // Per-particle removal flags
+
+        // --- Block Timesteps ---
+        std::vector<float> accX;              // Acceleration at the current position (last closing kick)
+        std::vector<float> accY;
+        std::vector<uint8_t> timeBin;         // Particle i steps tickDt * 2^timeBin[i]
+        std::vector<int> activeList;          // Particles kicked this tick (scratch)
+        std::vector<int> fineList;            // Particles below the top bin this frame
+        std::vector<uint8_t> nearEdge;        // Within two steps of a planet's cutoff or surface at frame start
+        std::vector<int> watchList;           // Top-bin particles with nearEdge set, re-checked every tick
+        std::vector<int> refineList;          // Watched particles leaving the top bin this tick (scratch)
+        std::vector<float> refineAccX, refineAccY;
+        std::vector<float> gatherX, gatherY;  // Active particles, contiguous for the SIMD kernels
+        std::vector<float> gatherAx, gatherAy;
+        uint64_t accLayout = ~0ull;           // layoutVersion accX/accY belong to (~0 = stale)
+        uint64_t forceEvaluations = 0;
+        uint64_t collisionCount = 0;          // Impacts resolved (approaching pairs that took an impulse)
+
+        // --- Compact Storage ---
+        // While active, `compact` holds the asteroids. The float arrays are
+        // empty except while a caller holds a syncParticles() mirror.
+        CompactParticleSystem compact;
+        bool compactActive = false;
+        bool mirrorFresh = false;
+
+        // --- Asteroid Self-Gravity ---
+        BarnesHutTree gravityTree;
+
+        // --- Step Pipeline ---
+        // step() picks one runSubsteps<Features> instantiation per call, so the
+        // per-block passes carry no feature branches and skip unused work
+        enum StepFeature : unsigned {
+            STEP_CENTRAL_GRAVITY = 1u << 0,
+            STEP_PLANETS         = 1u << 1,
+            STEP_COLLISIONS      = 1u << 2,
+            STEP_DAMPING         = 1u << 3,   // damping != 1, so the drift also scales velocities
+            STEP_SELF_GRAVITY    = 1u << 4,
+            STEP_FEATURE_COMBINATIONS = 1u << 5
+        };
+        using SubstepPipeline = void (ParticleKinematics::*)(const SimConfig&, float);
+
+        PhaseTimings timings;
 
     public:
-        ParticleKinematics(ParticleSystem& particles);
+        // workerThreads as in SimConfig; passing the configured value avoids
+        // starting a full-size pool that init() would shrink again
+        ParticleKinematics(ParticleSystem& particles, int workerThreads = 0);
 
         void init(const SimConfig& config);
+        // Takes over arrays that were filled externally (e.g. a restored checkpoint).
+        // stepsTaken keeps the reorder schedule, so a restored run continues bit-exactly.
+        void adoptState(uint64_t stepsTaken);
         // Note: step is no longer const because it can modify particles via spawn
         void step(SimConfig& config, float deltaTime);
 
+        const PhaseTimings& getTimings() const { return timings; }
+        // Particle i is the same body across steps until this changes (reset, restore, Z-order sort)
+        uint64_t getLayoutVersion() const { return layoutVersion; }
+        // Asteroid force evaluations so far (one per particle per substep without block steps)
+        uint64_t getForceEvaluations() const { return forceEvaluations; }
+        // Asteroid-asteroid impacts so far; deterministic like the collision solver itself
+        uint64_t getCollisionCount() const { return collisionCount; }
+        // Verlet pair list builds so far (hash rebuilds while SimConfig::verletSkin > 0)
+        uint64_t getPairListBuilds() const { return pairListBuilds; }
+        void resetTimings() { timings = PhaseTimings(); }
+
+        // Runs one phase of a substep (Forces, Integration, Collisions or
+        // Boundaries) over all particles as a separate pass, for kernel
+        // benchmarks; step() fuses them. False for any other phase.
+        bool runPhase(const SimConfig& config, ProfilePhase phase, float dt);
+
+        // Compact storage: particles.posX/... are empty or stale until syncParticles()
+        // widens the compact arrays into them. A no-op in float mode or when already
+        // fresh. releaseParticles() frees that mirror again, so between uses a
+        // compact run keeps 8 bytes per particle; a no-op in float mode.
+        void syncParticles();
+        void releaseParticles();
+        bool isCompact() const { return compactActive; }
+
+        // Copies the asteroids into `out`, widened from compact storage when it
+        // is active, so consumers that keep their own copy need no mirror.
+        // With `order`, out[k] is asteroid order[k]. Planets are not copied.
+        void copyAsteroids(ParticleSystem& out, const int* order = nullptr);
+        // Same into caller-owned arrays of getParticleCount() entries (e.g. a shared-memory slot)
+        void copyAsteroids(float* posX, float* posY, float* velX, float* velY, const int* order = nullptr);
+        int getParticleCount() const { return numParticles; }
+
     private:
         void processUserSpawns(SimConfig& config); // New method
+        void matchWorkerThreads(const SimConfig& config);
+        void appendBelt(const SimConfig& config, int count);
+        void resizeParticles(const SimConfig& config);
+        void truncateParticles(int count);
+        void removeAccreted(SimConfig& config);
         void updatePositions(const SimConfig& config, float dt);
-        void applyForces(const SimConfig& config, float dt);
+        void applyPlanetForces(const SimConfig& config, float dt);
+        void updatePlanetBatch();
+        // Planets that can touch the box [minX, maxX] x [minY, maxY], in index order
+        const PlanetBatch& nearbyPlanets(float minX, float minY, float maxX, float maxY, NearbyPlanets& scratch) const;
+        template <typename Fn>
+        void forEachPlanetNear(float minX, float minY, float maxX, float maxY, Fn&& fn) const;
+        void applyPlanetGravity(const float* posX, const float* posY, float* velX, float* velY,
+                                int begin, int end, float dt) const;
+        void movePlanets(float dt);
+        void bouncePlanets();
+        void applyInterParticleGravity(const SimConfig& config, float dt);
         void resolveCollisionsGrid(const SimConfig& config);
+        bool pairListStale(const SimConfig& config);
+        void buildPairList(const SimConfig& config);
+        void resolvePairList(const SimConfig& config);
         void applyBoundaryConditions(const SimConfig& config);
-        
-        int getGridIndex(float x, float y);
+        void reflectWalls(const SimConfig& config, int begin, int end);
+        unsigned stepFeatures(const SimConfig& config) const;
+        template <unsigned Features>
+        void runSubsteps(const SimConfig& config, float dt);
+        template <unsigned... Features>
+        static std::array<SubstepPipeline, sizeof...(Features)> makePipelines(std::integer_sequence<unsigned, Features...>);
+        void reorderParticles();
+
+        void stepBlockTimesteps(const SimConfig& config, float deltaTime);
+        void selectActive(int tick);          // activeList = fineList bodies whose steps start/end at tick
+        void evaluateAccelerations(const SimConfig& config, const std::vector<int>& indices);
+        int desiredTimeBin(const SimConfig& config, int i, float tickDt, int maxBin, bool* nearEdge = nullptr) const;
+        void refineTopBin(const SimConfig& config, int tick, float tickDt, int maxBin);
+
+        bool compactEligible(const SimConfig& config) const;
+        void enterCompactStorage();
+        void releaseFloatArrays();
+        void leaveCompactStorage();
+        void compactSubstep(const SimConfig& config, float dt, int substep);
 };
\ No newline at end of file
@@ -1,8 +1,10 @@
 #pragma once
 
 #include <vector>
+#include <cstddef>
 #include <cstdint>
 
+// One planet as a record: spawning, checkpoints and recordings use this form
 struct Planet {
     float x, y;
     float vx, vy;
@@ -11,6 +13,44 @@ struct Planet {
     uint32_t color;
 };
 
+// Planets in Structure of Arrays form, so the planet-planet pass and the
+// asteroid kernels can stream x/y/mass without striding over whole records
+struct PlanetSystem {
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> vx;
+    std::vector<float> vy;
+    std::vector<float> mass;
+    std::vector<float> radius;
+    std::vector<uint32_t> color;
+
+    size_t size() const { return x.size(); }
+    bool empty() const { return x.empty(); }
+
+    void clear() { resize(0); }
+    void resize(size_t count) {
+        x.resize(count); y.resize(count);
+        vx.resize(count); vy.resize(count);
+        mass.resize(count); radius.resize(count);
+        color.resize(count);
+    }
+
+    void push_back(const Planet& p) {
+        x.push_back(p.x); y.push_back(p.y);
+        vx.push_back(p.vx); vy.push_back(p.vy);
+        mass.push_back(p.mass); radius.push_back(p.radius);
+        color.push_back(p.color);
+    }
+
+    Planet get(size_t i) const { return Planet{ x[i], y[i], vx[i], vy[i], mass[i], radius[i], color[i] }; }
+    void set(size_t i, const Planet& p) {
+        x[i] = p.x; y[i] = p.y;
+        vx[i] = p.vx; vy[i] = p.vy;
+        mass[i] = p.mass; radius[i] = p.radius;
+        color[i] = p.color;
+    }
+};
+
 struct ParticleSystem {
     // Structure of Arrays (SoA) for efficient cache access of asteroids
     std::vector<float> posX;
@@ -18,6 +58,27 @@ struct ParticleSystem {
     std::vector<float> velX;
     std::vector<float> velY;
 
-    // Array of Structures (AoS) for planets (low count, cache irrelevant)
-    std::vector<Planet> planets;
-};
\ No newline at end of file
+    // Planets, also SoA: spawning can push their count into the thousands
+    PlanetSystem planets;
+};
+
+// Index over a ParticleSystem whose asteroids are stored in cell order: the
+// bodies of grid cell c = cy * cellsX + cx are [cellStart[c], cellStart[c + 1]).
+// Cells are cellSize wide from the box origin; bodies outside the box belong
+// to the border cells.
+struct ParticleCells {
+    int cellsX = 0;
+    int cellsY = 0;
+    float cellSize = 0.0f;
+    std::vector<int> cellStart;   // cellsX * cellsY + 1 entries
+};
+
+// Compact asteroid storage, 8 bytes per particle instead of 16: positions as
+// 16-bit fixed point over the domain, velocities as IEEE half precision.
+// Used in place of the float arrays when SimConfig::compactStorage is on.
+struct CompactParticleSystem {
+    std::vector<uint16_t> posX;
+    std::vector<uint16_t> posY;
+    std::vector<uint16_t> velX;
+    std::vector<uint16_t> velY;
+};
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+// Uniform grid over the simulation box, stored flat and rebuilt by counting sort.
+// Particles of cell c are sortedIndices[cellStart[c] .. cellStart[c] + cellCount[c]).
+class SpatialGrid {
+    public:
+        void resize(int width, int height, float cellSize);
+        void build(const float* posX, const float* posY, int count);
+
+        // Permutation that orders particles along a Z-order curve over the cells.
+        void mortonOrder(const float* posX, const float* posY, int count, std::vector<int>& order);
+
+        int cellIndex(float x, float y) const {
+            return cellY(y) * width + cellX(x);
+        }
+
+        // Cell column/row of a coordinate, clamped to the grid: points outside
+        // the box land in the border cells
+        int cellX(float x) const {
+            int cx = static_cast<int>(x * invCellSize);
+            return cx < 0 ? 0 : (cx >= width ? width - 1 : cx);
+        }
+        int cellY(float y) const {
+            int cy = static_cast<int>(y * invCellSize);
+            return cy < 0 ? 0 : (cy >= height ? height - 1 : cy);
+        }
+
+        int getWidth() const { return width; }
+        int getHeight() const { return height; }
+        int cellCountTotal() const { return width * height; }
+
+        std::vector<int> cellStart;
+        std::vector<int> cellCount;
+        std::vector<int> sortedIndices;
+
+    private:
+        void countParticles(const float* posX, const float* posY, int count);
+
+        int width = 0;
+        int height = 0;
+        float invCellSize = 1.0f;
+
+        std::vector<int> particleCell;   // Cell of each particle from the last count pass
+        std::vector<int> cursor;         // Scatter cursors (scratch)
+        std::vector<int> mortonCell;     // Cells listed in Z-order
+};
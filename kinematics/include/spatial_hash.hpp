@@ -0,0 +1,69 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// Sparse uniform grid: only occupied cells exist, found through an
+// open-addressing hash on the integer cell coordinates. Memory follows the
+// number of occupied cells, not the domain area, so the cell size can track
+// the collision radius. Rebuilt from scratch every substep.
+//
+// Cells are also grouped into square blocks of blockSize cells, and blocks
+// into four colors (2x2 checkerboard of blocks) for the parallel solver.
+// All orders follow first appearance in the particle arrays, so they are
+// deterministic for a given particle order.
+class SpatialHash {
+    public:
+        struct Cell {
+            int x, y;       // Integer cell coordinates
+            int start;      // First entry in sortedIndices
+            int count;
+        };
+
+        void build(const float* posX, const float* posY, int count, float cellSize, int blockSize);
+
+        // Occupied cell at (x, y), or -1
+        int find(int x, int y) const;
+
+        int cellCountTotal() const { return static_cast<int>(cells.size()); }
+        size_t memoryBytes() const;
+
+        std::vector<Cell> cells;
+        std::vector<int> sortedIndices;  // Particles of cells[c] are sortedIndices[start .. start + count)
+        std::vector<int> cellOrder;      // Cells grouped by block, blocks grouped by color
+        std::vector<int> blockStart;     // Block b is cellOrder[blockStart[b] .. blockStart[b + 1])
+        int colorStart[5] = {};          // Blocks of color k are [colorStart[k], colorStart[k + 1])
+
+    private:
+        // Open-addressing table from packed coordinates to a dense index
+        class Table {
+            public:
+                void reset(size_t expected);
+                int find(uint64_t key) const;
+                // Index of key, inserting `value` if absent; `inserted` reports which
+                int insert(uint64_t key, int value, bool& inserted);
+                size_t memoryBytes() const { return keys.capacity() * sizeof(uint64_t) + values.capacity() * sizeof(int); }
+
+            private:
+                void grow();
+
+                std::vector<uint64_t> keys;
+                std::vector<int> values;
+                size_t used = 0;
+                size_t mask = 0;
+        };
+
+        Table cellTable;
+        Table blockTable;
+        size_t lastCells = 0;
+        size_t lastBlocks = 0;
+
+        // --- Scratch ---
+        std::vector<int> particleCell;   // Cell of each particle
+        std::vector<int> cellBlock;      // Block of each cell
+        std::vector<int> blockColor;     // Color of each block
+        std::vector<int> blockRank;      // Position of each block in color order
+        std::vector<int> blockCursor;    // Cell counts by block, then scatter cursors by rank
+        std::vector<int> cursor;         // Particle scatter cursors by cell
+};
@@ -1,15 +1,142 @@
 #include "kinematics.hpp"
+#include "profiler.hpp"
 #include <iostream>
 #include <cmath>
 #include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <numeric>
+#include "philox.hpp"
 
-ParticleKinematics::ParticleKinematics(ParticleSystem& particles) : particles(particles) {
-    gridWidth = static_cast<int>(std::ceil(boxWidth / CELL_SIZE));
-    gridHeight = static_cast<int>(std::ceil(boxHeight / CELL_SIZE));
-    grid.resize(gridWidth * gridHeight);
+namespace {
+    // Philox streams: counter word 2 keeps planet draws apart from belt draws
+    constexpr uint32_t BELT_STREAM = 0;
+    constexpr uint32_t PLANET_STREAM = 1;
+
+    // Random numbers for body `index` of a stream, a pure function of the seed
+    Philox4x32 bodyRandom(uint32_t seed, uint32_t stream, uint64_t index) {
+        return Philox4x32::generate(static_cast<uint32_t>(index), static_cast<uint32_t>(index >> 32),
+                                    stream, 0, seed, 0x5EEDB1A5u);
+    }
+
+    // Domain units per compact position quantum
+    constexpr float COMPACT_POSITION_STEP = (SIM_WIDTH > SIM_HEIGHT ? SIM_WIDTH : SIM_HEIGHT) / 65535.0f;
+
+    // Round-to-nearest packing for mode switches (substeps dither instead)
+    uint16_t packPosition(float p) {
+        float q = p / COMPACT_POSITION_STEP + 0.5f;
+        if (!(q > 0.0f)) return 0;
+        if (q >= 65535.0f) return 65535;
+        return static_cast<uint16_t>(q);
+    }
+
+    uint16_t packVelocity(float v) {
+        uint32_t bits;
+        std::memcpy(&bits, &v, sizeof(bits));
+        bits += 0x1000u; // Half of the dropped mantissa bits, then truncation
+        std::memcpy(&v, &bits, sizeof(v));
+        return floatToHalf(v);
+    }
+
+    // Shared state of one collision pass
+    struct CollisionContext {
+        float* posX;
+        float* posY;
+        float* velX;
+        float* velY;
+        float minDist;
+        float minDistSq;
+        float restitution;
+
+        // Returns 1 when the pair was approaching and took an impulse (an impact)
+        int resolvePair(int i, int j) const {
+            float dx = posX[i] - posX[j];
+            float dy = posY[i] - posY[j];
+            float distSq = dx*dx + dy*dy;
+            if (distSq < minDistSq && distSq > 0.0001f) {
+                float dist = std::sqrt(distSq);
+                float overlap = (minDist - dist) * 0.5f;
+                float nx = dx / dist; float ny = dy / dist;
+                posX[i] += nx * overlap; posY[i] += ny * overlap;
+                posX[j] -= nx * overlap; posY[j] -= ny * overlap;
+                float dvx = velX[i] - velX[j];
+                float dvy = velY[i] - velY[j];
+                float velNormal = dvx * nx + dvy * ny;
+                if (velNormal < 0) {
+                    float impulse = -(1.0f + restitution) * velNormal * 0.5f;
+                    velX[i] += impulse * nx; velY[i] += impulse * ny;
+                    velX[j] -= impulse * nx; velY[j] -= impulse * ny;
+                    return 1;
+                }
+            }
+            return 0;
+        }
+    };
+
+    CollisionContext collisionContext(ParticleSystem& particles, const SimConfig& config) {
+        CollisionContext ctx;
+        ctx.posX = particles.posX.data();
+        ctx.posY = particles.posY.data();
+        ctx.velX = particles.velX.data();
+        ctx.velY = particles.velY.data();
+        ctx.minDist = config.collisionRadius * 2.0f;
+        ctx.minDistSq = ctx.minDist * ctx.minDist;
+        ctx.restitution = config.restitution;
+        return ctx;
+    }
+
+    // Visits all pairs inside an occupied cell and between it and its forward
+    // neighbors. The half stencil visits each unordered cell pair exactly once.
+    template <typename Fn>
+    void forEachCellPair(const SpatialHash& hash, int cellIdx, Fn&& fn) {
+        static constexpr int neighborOffsets[4][2] = {{1, 0}, {-1, 1}, {0, 1}, {1, 1}};
+
+        const SpatialHash::Cell& cellInfo = hash.cells[cellIdx];
+        int count = cellInfo.count;
+        const int* sorted = hash.sortedIndices.data();
+        const int* cell = sorted + cellInfo.start;
+
+        // Pairs inside the cell
+        for (int a = 0; a < count; ++a) {
+            for (int b = a + 1; b < count; ++b) {
+                fn(cell[a], cell[b]);
+            }
+        }
+
+        // Pairs with the forward neighbors that are occupied
+        for (const auto& offset : neighborOffsets) {
+            int neighborIdx = hash.find(cellInfo.x + offset[0], cellInfo.y + offset[1]);
+            if (neighborIdx < 0) continue;
+
+            const SpatialHash::Cell& neighborInfo = hash.cells[neighborIdx];
+            const int* neighbor = sorted + neighborInfo.start;
+            for (int a = 0; a < count; ++a) {
+                for (int b = 0; b < neighborInfo.count; ++b) {
+                    fn(cell[a], neighbor[b]);
+                }
+            }
+        }
+    }
+
+    // Resolves the pairs of one cell; returns the number of impacts
+    int resolveCellPairs(const SpatialHash& hash, const CollisionContext& ctx, int cellIdx) {
+        int impacts = 0;
+        forEachCellPair(hash, cellIdx, [&](int i, int j) { impacts += ctx.resolvePair(i, j); });
+        return impacts;
+    }
+}
+
+ParticleKinematics::ParticleKinematics(ParticleSystem& particles, int workerThreads)
+    : particles(particles), jobs(workerThreads), activeWorkerThreads(workerThreads), simd(simdKernels()) {
+    int gridWidth = static_cast<int>(std::ceil(boxWidth / CELL_SIZE));
+    int gridHeight = static_cast<int>(std::ceil(boxHeight / CELL_SIZE));
+    grid.resize(gridWidth, gridHeight, CELL_SIZE);
+    planetGrid.resize(static_cast<int>(std::ceil(boxWidth / PLANET_CUTOFF)),
+                      static_cast<int>(std::ceil(boxHeight / PLANET_CUTOFF)), PLANET_CUTOFF);
     
     std::cout << "[ParticleKinematics] Initialized with Grid: " 
-              << gridWidth << "x" << gridHeight << std::endl;
+              << gridWidth << "x" << gridHeight
+              << ", SIMD: " << simd.name << std::endl;
 }
 
 void ParticleKinematics::init(const SimConfig& config) {
@@ -20,16 +147,19 @@ void ParticleKinematics::init(const SimConfig& config) {
     particles.velY.clear();
     particles.planets.clear();
 
-    numParticles = config.particleCount;
-
-    particles.posX.reserve(numParticles);
-    particles.posY.reserve(numParticles);
-    particles.velX.reserve(numParticles);
-    particles.velY.reserve(numParticles);
+    numParticles = 0;
+    layoutVersion++;
+    compactActive = false;
+    compact = CompactParticleSystem();
 
     float centerX = boxWidth / 2.0f;
     float centerY = boxHeight / 2.0f;
 
+    // Counter-based draws: identical configs produce identical systems on
+    // any machine and thread count
+    beltGenerated = 0;
+    matchWorkerThreads(config);
+
     // 2. Initialize Planets
     struct PlanetInit { float dist; float mass; float r; uint32_t col; };
     std::vector<PlanetInit> pInits = {
@@ -38,9 +168,10 @@ void ParticleKinematics::init(const SimConfig& config) {
         { 120.0f, 3000.0f, 8.0f, 0xFFFFAA00 } // Jupiter-ish
     };
 
-    for (const auto& pDef : pInits) {
+    for (size_t k = 0; k < pInits.size(); ++k) {
+        const PlanetInit& pDef = pInits[k];
         Planet p;
-        float angle = (static_cast<float>(rand()) / RAND_MAX) * 2.0f * M_PI;
+        float angle = bodyRandom(config.seed, PLANET_STREAM, k).uniform(0) * 2.0f * M_PI;
         p.x = centerX + std::cos(angle) * pDef.dist;
         p.y = centerY + std::sin(angle) * pDef.dist;
         p.mass = pDef.mass;
@@ -54,51 +185,265 @@ void ParticleKinematics::init(const SimConfig& config) {
         particles.planets.push_back(p);
     }
 
-    // 3. Initialize Asteroid Belt
-    for (int i = 0; i < numParticles; ++i) {
-        float angle = (static_cast<float>(rand()) / RAND_MAX) * 2.0f * M_PI;
-        
-        float minR = 80.0f;
-        float maxR = 110.0f;
-        float rRand = static_cast<float>(rand()) / RAND_MAX;
-        float radius = std::sqrt(rRand) * (maxR - minR) + minR;
+    // 3. Initialize Asteroid Belt, straight into the compact arrays when
+    //    step() would use them, so the float arrays are never allocated
+    if (compactEligible(config)) {
+        compactActive = true;
+        mirrorFresh = false;
+        releaseFloatArrays();
+    }
+    appendBelt(config, config.particleCount);
+    if (compactActive) {
+        std::cout << "[ParticleKinematics] Compact storage on: " << numParticles << " particles, "
+                  << (static_cast<double>(numParticles) * 8.0 / (1024.0 * 1024.0)) << " MB" << std::endl;
+    }
+}
 
-        float px = centerX + std::cos(angle) * radius;
-        float py = centerY + std::sin(angle) * radius;
+void ParticleKinematics::appendBelt(const SimConfig& config, int count) {
+    int first = numParticles;
+    numParticles += count;
+    if (compactActive) {
+        compact.posX.resize(numParticles);
+        compact.posY.resize(numParticles);
+        compact.velX.resize(numParticles);
+        compact.velY.resize(numParticles);
+    } else {
+        particles.posX.resize(numParticles);
+        particles.posY.resize(numParticles);
+        particles.velX.resize(numParticles);
+        particles.velY.resize(numParticles);
+    }
 
-        particles.posX.push_back(px);
-        particles.posY.push_back(py);
-        
-        float dist = radius; 
-        float orbitalSpeed = std::sqrt(config.starMass / dist);
-        float variation = 1.0f + ((static_cast<float>(rand()) / RAND_MAX) - 0.5f) * 0.15f;
+    const float centerX = boxWidth / 2.0f;
+    const float centerY = boxHeight / 2.0f;
+    const float minR = 80.0f;
+    const float maxR = 110.0f;
+
+    // Body k of the belt draws from counter k, so the arrays fill in parallel
+    // and growing in steps reproduces one big init
+    const uint64_t counterBase = beltGenerated - static_cast<uint64_t>(first);
+    jobs.parallelFor(count, PARALLEL_GRAIN, [&](int begin, int end) {
+        for (int i = first + begin; i < first + end; ++i) {
+            Philox4x32 r = bodyRandom(config.seed, BELT_STREAM, counterBase + static_cast<uint64_t>(i));
+            float angle = r.uniform(0) * 2.0f * M_PI;
+            float radius = std::sqrt(r.uniform(1)) * (maxR - minR) + minR;
+
+            float orbitalSpeed = std::sqrt(config.starMass / radius);
+            float variation = 1.0f + (r.uniform(2) - 0.5f) * 0.15f;
 
-        particles.velX.push_back(-std::sin(angle) * orbitalSpeed * variation);
-        particles.velY.push_back(std::cos(angle) * orbitalSpeed * variation);
+            float x = centerX + std::cos(angle) * radius;
+            float y = centerY + std::sin(angle) * radius;
+            float vx = -std::sin(angle) * orbitalSpeed * variation;
+            float vy = std::cos(angle) * orbitalSpeed * variation;
+
+            // Packed as enterCompactStorage() would, so both routes give the same state
+            if (compactActive) {
+                compact.posX[i] = packPosition(x);
+                compact.posY[i] = packPosition(y);
+                compact.velX[i] = packVelocity(vx);
+                compact.velY[i] = packVelocity(vy);
+            } else {
+                particles.posX[i] = x;
+                particles.posY[i] = y;
+                particles.velX[i] = vx;
+                particles.velY[i] = vy;
+            }
+        }
+    });
+    beltGenerated += static_cast<uint64_t>(count);
+}
+
+void ParticleKinematics::resizeParticles(const SimConfig& config) {
+    int target = std::max(0, config.particleCount);
+    if (target > numParticles) {
+        appendBelt(config, target - numParticles);
+    } else if (target < numParticles) {
+        // Thin evenly along the (Z-ordered) arrays instead of cutting off the
+        // tail, which would empty one region of the belt
+        int kept = 0;
+        for (int i = 0; i < numParticles; ++i) {
+            bool keep = (static_cast<int64_t>(i + 1) * target) / numParticles >
+                        (static_cast<int64_t>(i) * target) / numParticles;
+            if (!keep) continue;
+            particles.posX[kept] = particles.posX[i];
+            particles.posY[kept] = particles.posY[i];
+            particles.velX[kept] = particles.velX[i];
+            particles.velY[kept] = particles.velY[i];
+            kept++;
+        }
+        truncateParticles(kept);
+    }
+    layoutVersion++;
+}
+
+void ParticleKinematics::truncateParticles(int count) {
+    numParticles = count;
+    particles.posX.resize(count);
+    particles.posY.resize(count);
+    particles.velX.resize(count);
+    particles.velY.resize(count);
+}
+
+void ParticleKinematics::removeAccreted(SimConfig& config) {
+    // 1. Flag bodies inside the star or a planet, at the planets' end-of-step positions
+    updatePlanetBatch();
+    accreted.assign(numParticles, 0);
+    const float starRadiusSq = config.starRadius * config.starRadius;
+    const float* posX = particles.posX.data();
+    const float* posY = particles.posY.data();
+
+    jobs.parallelFor(numParticles, PARALLEL_GRAIN, [&](int begin, int end) {
+        NearbyPlanets nearby;
+        for (int t = begin; t < end; t += PLANET_TILE) {
+            int tileEnd = std::min(t + PLANET_TILE, end);
+            float minX = posX[t], maxX = posX[t], minY = posY[t], maxY = posY[t];
+            for (int i = t + 1; i < tileEnd; ++i) {
+                minX = std::min(minX, posX[i]); maxX = std::max(maxX, posX[i]);
+                minY = std::min(minY, posY[i]); maxY = std::max(maxY, posY[i]);
+            }
+            const PlanetBatch& planets = nearbyPlanets(minX, minY, maxX, maxY, nearby);
+
+            for (int i = t; i < tileEnd; ++i) {
+                float dx = posX[i] - config.starX;
+                float dy = posY[i] - config.starY;
+                bool inside = config.enableCentralGravity && dx*dx + dy*dy < starRadiusSq;
+                for (int p = 0; p < planets.count && !inside; ++p) {
+                    float pdx = posX[i] - planets.x[p];
+                    float pdy = posY[i] - planets.y[p];
+                    inside = pdx*pdx + pdy*pdy < planets.radiusSq[p];
+                }
+                accreted[i] = inside;
+            }
+        }
+    });
+
+    // 2. Swap-remove: the last live body fills each hole
+    int n = numParticles;
+    for (int i = 0; i < n;) {
+        if (!accreted[i]) { ++i; continue; }
+        --n;
+        particles.posX[i] = particles.posX[n];
+        particles.posY[i] = particles.posY[n];
+        particles.velX[i] = particles.velX[n];
+        particles.velY[i] = particles.velY[n];
+        accreted[i] = accreted[n];
+    }
+
+    if (n != numParticles) {
+        truncateParticles(n);
+        config.particleCount = n;
+        layoutVersion++;
+    }
+}
+
+void ParticleKinematics::adoptState(uint64_t stepsTaken) {
+    compactActive = false;
+    compact = CompactParticleSystem();
+    numParticles = static_cast<int>(particles.posX.size());
+    stepCount = stepsTaken;
+    layoutVersion++;
+    beltGenerated = static_cast<uint64_t>(numParticles); // Growth continues past the restored bodies
+}
+
+void ParticleKinematics::matchWorkerThreads(const SimConfig& config) {
+    if (config.workerThreads != activeWorkerThreads) {
+        jobs.resize(config.workerThreads);
+        activeWorkerThreads = config.workerThreads;
     }
 }
 
 void ParticleKinematics::step(SimConfig& config, float deltaTime) {
+    // 0. Population edits and the float-only passes work on the float arrays
+    if (compactActive && (!compactEligible(config) || config.spawnClick ||
+                          numParticles != config.particleCount)) {
+        leaveCompactStorage();
+    }
+
     // 1. Handle Spawning (Even if paused, so users can place objects)
     processUserSpawns(config);
 
     // 2. Pause Logic
     if (config.paused) return;
 
-    // 3. Check for Reset
-    if (static_cast<int>(particles.posX.size()) != config.particleCount) {
-        init(config);
+    ProfileScope stepScope(ProfilePhase::Step);
+
+    // 3. Grow or shrink in place to the requested count
+    if (numParticles != config.particleCount) {
+        resizeParticles(config);
     }
 
+    // 4. Match the worker pool to the requested thread count
+    matchWorkerThreads(config);
+
     float subDt = deltaTime / static_cast<float>(config.substeps);
-    
-    for (int s = 0; s < config.substeps; ++s) {
-        applyForces(config, subDt);
-        updatePositions(config, subDt);
-        if (config.enableCollisions) {
-            resolveCollisionsGrid(config);
+
+    // Gravity-only runs can stream the compact arrays instead. Every pass is
+    // per-particle there, so memory order does not matter and reorder is skipped.
+    if (compactEligible(config)) {
+        if (!compactActive) enterCompactStorage();
+        for (int s = 0; s < config.substeps; ++s) {
+            compactSubstep(config, subDt, s);
         }
-        applyBoundaryConditions(config);
+        stepCount++;
+        mirrorFresh = false;
+        accLayout = ~0ull;
+        return;
+    }
+
+    // 5. Keep memory order close to spatial order so cell neighbors share cache lines
+    if (config.reorderInterval > 0 && stepCount % static_cast<uint64_t>(config.reorderInterval) == 0) {
+        ProfileScope scope(ProfilePhase::Reorder, &timings.reorder);
+        reorderParticles();
+    }
+    stepCount++;
+
+    if (config.blockTimesteps) {
+        stepBlockTimesteps(config, deltaTime);
+    } else {
+        accLayout = ~0ull; // Positions move without the block path's accelerations
+        static const auto pipelines = makePipelines(std::make_integer_sequence<unsigned, STEP_FEATURE_COMBINATIONS>());
+        (this->*pipelines[stepFeatures(config)])(config, subDt);
+    }
+
+    // 6. Drop bodies that fell into the star or a planet
+    if (config.enableAccretion) {
+        ProfileScope scope(ProfilePhase::Boundaries, &timings.boundaries);
+        removeAccreted(config);
+    }
+}
+
+bool ParticleKinematics::runPhase(const SimConfig& config, ProfilePhase phase, float dt) {
+    if (compactActive) leaveCompactStorage();
+    matchWorkerThreads(config);
+    accLayout = ~0ull;
+
+    switch (phase) {
+        case ProfilePhase::Forces:
+            applyPlanetForces(config, dt);
+            jobs.parallelFor(numParticles, PARALLEL_GRAIN, [&](int begin, int end) {
+                if (config.enableCentralGravity) {
+                    simd.centralGravity(particles.posX.data(), particles.posY.data(),
+                                        particles.velX.data(), particles.velY.data(), begin, end,
+                                        config.starX, config.starY, config.starMass, STAR_SOFTENING_SQ, dt);
+                }
+                if (planetBatch.count > 0) {
+                    applyPlanetGravity(particles.posX.data(), particles.posY.data(),
+                                       particles.velX.data(), particles.velY.data(), begin, end, dt);
+                }
+            });
+            if (config.enableInterParticleGravity) applyInterParticleGravity(config, dt);
+            return true;
+        case ProfilePhase::Integration:
+            updatePositions(config, dt);
+            return true;
+        case ProfilePhase::Collisions:
+            resolveCollisionsGrid(config);
+            return true;
+        case ProfilePhase::Boundaries:
+            applyBoundaryConditions(config);
+            return true;
+        default:
+            return false;
     }
 }
 
@@ -155,189 +500,879 @@ void ParticleKinematics::processUserSpawns(SimConfig& config) {
     }
 }
 
-void ParticleKinematics::applyForces(const SimConfig& config, float dt) {
-    float centerX = config.starX;
-    float centerY = config.starY;
-    float starMass = config.starMass;
+void ParticleKinematics::applyPlanetForces(const SimConfig& config, float dt) {
+    PlanetSystem& planets = particles.planets;
+    int numPlanets = static_cast<int>(planets.size());
 
-    // --- 1. Update Planets Forces (N-Body Gravity) ---
-    // Now iterating with index to allow nested comparison
-    size_t numPlanets = particles.planets.size();
-    
-    for (size_t i = 0; i < numPlanets; ++i) {
-        Planet& p1 = particles.planets[i];
-        
-        // A. Star Gravity (Star -> Planet)
-        float dx = centerX - p1.x;
-        float dy = centerY - p1.y;
+    // --- 1. Star Gravity (Star -> Planet) ---
+    for (int i = 0; i < numPlanets; ++i) {
+        float dx = config.starX - planets.x[i];
+        float dy = config.starY - planets.y[i];
         float distSq = dx*dx + dy*dy;
         float dist = std::sqrt(distSq);
         
         if (dist > 1.0f) {
-            float force = starMass / distSq;
-            p1.vx += (dx / dist) * force * dt;
-            p1.vy += (dy / dist) * force * dt;
+            float force = config.starMass / distSq;
+            planets.vx[i] += (dx / dist) * force * dt;
+            planets.vy[i] += (dy / dist) * force * dt;
         }
+    }
 
-        // B. Mutual Planet Gravity (Planet <-> Planet)
-        // O(N^2) loop, but N is small (planets)
-        for (size_t j = i + 1; j < numPlanets; ++j) {
-            Planet& p2 = particles.planets[j];
-            
-            float pdx = p2.x - p1.x;
-            float pdy = p2.y - p1.y;
-            float pDistSq = pdx*pdx + pdy*pdy;
-            float pDist = std::sqrt(pDistSq);
-            
-            // Softening radius to prevent singularity slingshots
-            float minSep = p1.radius + p2.radius;
-            if (pDist > minSep) {
-                // F = G * m1 * m2 / r^2
-                // We assume G=1 consistent with star logic
-                // a1 = F/m1 = m2/r^2
-                // a2 = F/m2 = m1/r^2
-                
-                float accel1 = p2.mass / pDistSq;
-                float accel2 = p1.mass / pDistSq;
-                
-                float nx = pdx / pDist;
-                float ny = pdy / pDist;
-                
-                // p1 is pulled towards p2
-                p1.vx += nx * accel1 * dt;
-                p1.vy += ny * accel1 * dt;
-                
-                // p2 is pulled towards p1 (Newton's 3rd Law)
-                p2.vx -= nx * accel2 * dt;
-                p2.vy -= ny * accel2 * dt;
+    // --- 2. Mutual Planet Gravity (Planet <-> Planet) ---
+    // Each planet sums the pull of all others from positions alone (G = 1,
+    // pairs closer than their radii are skipped to prevent slingshots). Every
+    // pair is visited from both ends, but the pass vectorizes and splits into
+    // independent ranges, which wins once spawning brings hundreds of planets.
+    jobs.parallelFor(numPlanets, PLANET_PAIR_GRAIN, [&](int begin, int end) {
+        simd.planetPairs(planets.x.data(), planets.y.data(), planets.mass.data(), planets.radius.data(),
+                         planets.vx.data(), planets.vy.data(), begin, end, numPlanets, dt);
+    });
+
+    // --- 3. Planet Batch ---
+    updatePlanetBatch();
+}
+
+void ParticleKinematics::updatePlanetBatch() {
+    // The SIMD kernels read the planet SoA directly; only radius^2 is derived
+    const PlanetSystem& planets = particles.planets;
+    int numPlanets = static_cast<int>(planets.size());
+    planetRadiusSq.resize(numPlanets);
+    float maxRadius = 0.0f;
+    for (int i = 0; i < numPlanets; ++i) {
+        planetRadiusSq[i] = planets.radius[i] * planets.radius[i];
+        maxRadius = std::max(maxRadius, planets.radius[i]);
+    }
+
+    planetBatch.x = planets.x.data(); planetBatch.y = planets.y.data();
+    planetBatch.mass = planets.mass.data(); planetBatch.radiusSq = planetRadiusSq.data();
+    planetBatch.count = numPlanets;
+
+    // The margin keeps float rounding at the cutoff from dropping a planet
+    planetReach = std::max(PLANET_CUTOFF, maxRadius) + 1.0f;
+    if (numPlanets >= PLANET_CULL_MIN) {
+        planetGrid.build(planets.x.data(), planets.y.data(), numPlanets);
+    }
+}
+
+template <typename Fn>
+void ParticleKinematics::forEachPlanetNear(float minX, float minY, float maxX, float maxY, Fn&& fn) const {
+    minX -= planetReach; maxX += planetReach;
+    minY -= planetReach; maxY += planetReach;
+    const float* px = planetBatch.x;
+    const float* py = planetBatch.y;
+
+    if (planetBatch.count < PLANET_CULL_MIN) {
+        for (int p = 0; p < planetBatch.count; ++p) {
+            if (px[p] >= minX && px[p] <= maxX && py[p] >= minY && py[p] <= maxY) fn(p);
+        }
+        return;
+    }
+
+    // Clamping is monotonic, so planets outside the box are still found in
+    // the border cells of the range
+    int cx0 = planetGrid.cellX(minX), cx1 = planetGrid.cellX(maxX);
+    int cy0 = planetGrid.cellY(minY), cy1 = planetGrid.cellY(maxY);
+    int width = planetGrid.getWidth();
+    for (int cy = cy0; cy <= cy1; ++cy) {
+        for (int cx = cx0; cx <= cx1; ++cx) {
+            int c = cy * width + cx;
+            int start = planetGrid.cellStart[c];
+            for (int k = start; k < start + planetGrid.cellCount[c]; ++k) {
+                int p = planetGrid.sortedIndices[k];
+                if (px[p] >= minX && px[p] <= maxX && py[p] >= minY && py[p] <= maxY) fn(p);
+            }
+        }
+    }
+}
+
+const PlanetBatch& ParticleKinematics::nearbyPlanets(float minX, float minY, float maxX, float maxY,
+                                                      NearbyPlanets& scratch) const {
+    if (planetBatch.count < PLANET_CULL_MIN) return planetBatch;
+
+    // Tiles without spatial locality (no reorder, compact storage) span most
+    // of the grid; gathering would then cost more than it culls
+    int spanX = planetGrid.cellX(maxX + planetReach) - planetGrid.cellX(minX - planetReach) + 1;
+    int spanY = planetGrid.cellY(maxY + planetReach) - planetGrid.cellY(minY - planetReach) + 1;
+    if (spanX * spanY * 2 > planetGrid.cellCountTotal()) return planetBatch;
+
+    scratch.index.clear();
+    forEachPlanetNear(minX, minY, maxX, maxY, [&](int p) { scratch.index.push_back(p); });
+    // Index order keeps each asteroid's sum in the same order as over all planets
+    std::sort(scratch.index.begin(), scratch.index.end());
+
+    size_t count = scratch.index.size();
+    scratch.x.resize(count); scratch.y.resize(count);
+    scratch.mass.resize(count); scratch.radiusSq.resize(count);
+    for (size_t k = 0; k < count; ++k) {
+        int p = scratch.index[k];
+        scratch.x[k] = planetBatch.x[p];
+        scratch.y[k] = planetBatch.y[p];
+        scratch.mass[k] = planetBatch.mass[p];
+        scratch.radiusSq[k] = planetBatch.radiusSq[p];
+    }
+    scratch.batch.x = scratch.x.data(); scratch.batch.y = scratch.y.data();
+    scratch.batch.mass = scratch.mass.data(); scratch.batch.radiusSq = scratch.radiusSq.data();
+    scratch.batch.count = static_cast<int>(count);
+    return scratch.batch;
+}
+
+void ParticleKinematics::applyPlanetGravity(const float* posX, const float* posY, float* velX, float* velY,
+                                            int begin, int end, float dt) const {
+    const float planetCutoffSq = PLANET_CUTOFF * PLANET_CUTOFF;
+    if (planetBatch.count < PLANET_CULL_MIN) {
+        simd.planetGravity(posX, posY, velX, velY, begin, end, planetBatch, planetCutoffSq, dt);
+        return;
+    }
+
+    // Tiles are runs of consecutive indices; after the Z-order reorder they
+    // cover small areas, so the gathered lists stay short. Tiles start on
+    // multiples of the vector width from `begin`, so the SIMD lanes group
+    // the same particles as one call over the whole range.
+    NearbyPlanets nearby;
+    for (int t = begin; t < end; t += PLANET_TILE) {
+        int tileEnd = std::min(t + PLANET_TILE, end);
+        float minX = posX[t], maxX = posX[t], minY = posY[t], maxY = posY[t];
+        for (int i = t + 1; i < tileEnd; ++i) {
+            minX = std::min(minX, posX[i]); maxX = std::max(maxX, posX[i]);
+            minY = std::min(minY, posY[i]); maxY = std::max(maxY, posY[i]);
+        }
+        const PlanetBatch& planets = nearbyPlanets(minX, minY, maxX, maxY, nearby);
+        if (planets.count > 0) {
+            simd.planetGravity(posX, posY, velX, velY, t, tileEnd, planets, planetCutoffSq, dt);
+        }
+    }
+}
+
+void ParticleKinematics::stepBlockTimesteps(const SimConfig& config, float deltaTime) {
+    // The frame is split into a power-of-two number of ticks. Particle i runs
+    // kick-drift-kick leapfrog with step tickDt * 2^timeBin[i]; every step
+    // starts and ends on a multiple of its own length, so all particles are
+    // synchronized again at the end of the frame. Everyone drifts, collides
+    // and bounces every tick; only kicks at step ends evaluate forces.
+    int ticks = 1, maxBin = 0;
+    while (ticks < config.substeps) { ticks <<= 1; maxBin++; }
+    float tickDt = deltaTime / static_cast<float>(ticks);
+
+    // Accelerations carry over between frames. After a layout change or a
+    // step on another path, start from a full evaluation.
+    if (accLayout != layoutVersion || static_cast<int>(accX.size()) != numParticles) {
+        ProfileScope scope(ProfilePhase::Forces, &timings.forces);
+        accX.assign(numParticles, 0.0f);
+        accY.assign(numParticles, 0.0f);
+        timeBin.assign(numParticles, 0);
+        activeList.resize(numParticles);
+        for (int i = 0; i < numParticles; ++i) activeList[i] = i;
+        updatePlanetBatch();
+        evaluateAccelerations(config, activeList);
+        accLayout = layoutVersion;
+    }
+
+    float* velX = particles.velX.data();
+    float* velY = particles.velY.data();
+
+    for (int t = 0; t < ticks; ++t) {
+        // 1. Planets kick on every tick, as in the substep path
+        {
+            ProfileScope scope(ProfilePhase::Forces, &timings.forces);
+            applyPlanetForces(config, tickDt);
+        }
+
+        // 2. Opening half-kicks: steps starting now choose their bin, limited
+        //    to bins whose steps are aligned with this tick
+        {
+            ProfileScope scope(ProfilePhase::Integration, &timings.integration);
+            int alignedBin = t == 0 ? maxBin : std::min(__builtin_ctz(static_cast<unsigned>(t)), maxBin);
+            if (t == 0) {
+                activeList.resize(numParticles);
+                std::iota(activeList.begin(), activeList.end(), 0);
+                nearEdge.resize(numParticles);
+            } else {
+                selectActive(t);
+            }
+            jobs.parallelFor(static_cast<int>(activeList.size()), PARALLEL_GRAIN, [&](int begin, int end) {
+                for (int k = begin; k < end; ++k) {
+                    int i = activeList[k];
+                    bool edge = false;
+                    int bin = std::min(desiredTimeBin(config, i, tickDt, maxBin, t == 0 ? &edge : nullptr), alignedBin);
+                    if (t == 0) nearEdge[i] = edge;
+                    timeBin[i] = static_cast<uint8_t>(bin);
+                    float halfStep = 0.5f * tickDt * static_cast<float>(1 << bin);
+                    velX[i] += accX[i] * halfStep;
+                    velY[i] += accY[i] * halfStep;
+                }
+            });
+
+            // Only bodies below the top bin can start or end a step mid-frame.
+            // Top-bin bodies close to a planet edge are watched, so that
+            // refineTopBin() can move them down if they bend towards it.
+            if (t == 0) {
+                fineList.clear();
+                watchList.clear();
+                for (int i = 0; i < numParticles; ++i) {
+                    if (timeBin[i] < maxBin) fineList.push_back(i);
+                    else if (nearEdge[i]) watchList.push_back(i);
+                }
+            }
+
+            // 3. Everyone drifts one tick
+            updatePositions(config, tickDt);
+        }
+
+        // 4. Closing half-kicks at the new positions
+        {
+            ProfileScope scope(ProfilePhase::Forces, &timings.forces);
+            updatePlanetBatch();
+            if (t + 1 == ticks) {
+                activeList.resize(numParticles);
+                std::iota(activeList.begin(), activeList.end(), 0);
             } else {
-                // Optional: Simple overlap push (bounce)
-                // Just to prevent them from sitting inside each other
-                // but without momentum transfer for simplicity right now
+                selectActive(t + 1);
             }
+            evaluateAccelerations(config, activeList);
+            jobs.parallelFor(static_cast<int>(activeList.size()), PARALLEL_GRAIN, [&](int begin, int end) {
+                for (int k = begin; k < end; ++k) {
+                    int i = activeList[k];
+                    float halfStep = 0.5f * tickDt * static_cast<float>(1 << timeBin[i]);
+                    velX[i] += accX[i] * halfStep;
+                    velY[i] += accY[i] * halfStep;
+                }
+            });
+            if (t + 1 < ticks && !watchList.empty()) refineTopBin(config, t + 1, tickDt, maxBin);
+        }
+
+        if (config.enableCollisions) {
+            ProfileScope scope(ProfilePhase::Collisions, &timings.collisions);
+            resolveCollisionsGrid(config);
+        }
+        {
+            ProfileScope scope(ProfilePhase::Boundaries, &timings.boundaries);
+            applyBoundaryConditions(config);
         }
     }
+}
 
-    // --- 2. Update Asteroid Forces ---
-    for (int i = 0; i < numParticles; ++i) {
-        // A. Star Gravity
-        if (config.enableCentralGravity) {
-            float dx = centerX - particles.posX[i];
-            float dy = centerY - particles.posY[i];
-            float distSq = dx*dx + dy*dy;
-            float softeningSq = 5.0f; 
-            float dist = std::sqrt(distSq + softeningSq);
-            float force = starMass / (distSq + softeningSq); 
+void ParticleKinematics::selectActive(int tick) {
+    activeList.clear();
+    for (int i : fineList) {
+        if ((tick & ((1 << timeBin[i]) - 1)) == 0) activeList.push_back(i);
+    }
+}
 
-            particles.velX[i] += (dx / dist) * force * dt; 
-            particles.velY[i] += (dy / dist) * force * dt;
+void ParticleKinematics::evaluateAccelerations(const SimConfig& config, const std::vector<int>& indices) {
+    int count = static_cast<int>(indices.size());
+    if (count == 0) return;
+    forceEvaluations += static_cast<uint64_t>(count);
+
+    gatherX.resize(count); gatherY.resize(count);
+    gatherAx.resize(count); gatherAy.resize(count);
+
+    // Active particles are gathered so the SIMD kernels see contiguous arrays;
+    // with dt = 1 the kernels' velocity update is the acceleration itself
+    jobs.parallelFor(count, PARALLEL_GRAIN, [&](int begin, int end) {
+        for (int k = begin; k < end; ++k) {
+            gatherX[k] = particles.posX[indices[k]];
+            gatherY[k] = particles.posY[indices[k]];
+            gatherAx[k] = 0.0f;
+            gatherAy[k] = 0.0f;
+        }
+        if (config.enableCentralGravity) {
+            simd.centralGravity(gatherX.data(), gatherY.data(), gatherAx.data(), gatherAy.data(), begin, end,
+                                config.starX, config.starY, config.starMass, STAR_SOFTENING_SQ, 1.0f);
+        }
+        if (planetBatch.count > 0) {
+            applyPlanetGravity(gatherX.data(), gatherY.data(), gatherAx.data(), gatherAy.data(), begin, end, 1.0f);
         }
+    });
 
-        // B. Planet Gravity
-        for (const auto& p : particles.planets) {
-            float dx = p.x - particles.posX[i];
-            float dy = p.y - particles.posY[i];
-            float distSq = dx*dx + dy*dy;
-            
-            if (distSq < 400.0f && distSq > (p.radius * p.radius)) {
-                float dist = std::sqrt(distSq);
-                float force = p.mass / distSq;
-                particles.velX[i] += (dx / dist) * force * dt;
-                particles.velY[i] += (dy / dist) * force * dt;
+    if (config.enableInterParticleGravity) {
+        // Sources are all particles at their current (drifted) positions
+        gravityTree.build(particles.posX.data(), particles.posY.data(), numParticles);
+        jobs.parallelFor(count, PARALLEL_GRAIN / 4, [&](int begin, int end) {
+            for (int k = begin; k < end; ++k) {
+                float ax, ay;
+                gravityTree.computeAcceleration(gatherX[k], gatherY[k], config.barnesHutTheta, 1.0f, ax, ay);
+                gatherAx[k] += ax * config.interParticleG;
+                gatherAy[k] += ay * config.interParticleG;
             }
+        });
+    }
+
+    jobs.parallelFor(count, PARALLEL_GRAIN, [&](int begin, int end) {
+        for (int k = begin; k < end; ++k) {
+            accX[indices[k]] = gatherAx[k];
+            accY[indices[k]] = gatherAy[k];
         }
+    });
+}
+
+void ParticleKinematics::refineTopBin(const SimConfig& config, int tick, float tickDt, int maxBin) {
+    // A watched body that now wants a finer bin (its path bent towards a
+    // planet edge the straight-line check at frame start missed) ends its
+    // top-bin step here: the opening kick is
+    // trimmed to the elapsed time, it takes a closing kick at the current
+    // position and continues in bin 0, choosing its next bin at this tick.
+    refineList.clear();
+    for (int i : watchList) {
+        if (timeBin[i] == maxBin && desiredTimeBin(config, i, tickDt, maxBin) < maxBin) refineList.push_back(i);
+    }
+    if (refineList.empty()) return;
+
+    int count = static_cast<int>(refineList.size());
+    refineAccX.resize(count);
+    refineAccY.resize(count);
+    for (int k = 0; k < count; ++k) {
+        refineAccX[k] = accX[refineList[k]];
+        refineAccY[k] = accY[refineList[k]];
+    }
+    evaluateAccelerations(config, refineList);
+
+    float elapsed = tickDt * static_cast<float>(tick);
+    float planned = tickDt * static_cast<float>(1 << maxBin);
+    for (int k = 0; k < count; ++k) {
+        int i = refineList[k];
+        particles.velX[i] += 0.5f * (refineAccX[k] * (elapsed - planned) + accX[i] * elapsed);
+        particles.velY[i] += 0.5f * (refineAccY[k] * (elapsed - planned) + accY[i] * elapsed);
+        timeBin[i] = 0;
+        fineList.push_back(i);
     }
 }
 
-void ParticleKinematics::updatePositions(const SimConfig& config, float dt) {
-    for (auto& p : particles.planets) {
-        p.x += p.vx * dt;
-        p.y += p.vy * dt;
+int ParticleKinematics::desiredTimeBin(const SimConfig& config, int i, float tickDt, int maxBin, bool* nearEdge) const {
+    // Acceleration criterion: dt <= accuracy * sqrt(L / |a|), with L = 1 unit.
+    // Steps never exceed the frame, so neither does the limit.
+    float limit = tickDt * static_cast<float>(1 << maxBin);
+    float aSq = accX[i] * accX[i] + accY[i] * accY[i];
+    float accuracySq = config.timestepAccuracy * config.timestepAccuracy;
+    if (aSq * limit * limit * limit * limit > accuracySq * accuracySq) {
+        limit = config.timestepAccuracy / std::sqrt(std::sqrt(aSq));
     }
-    for (int i = 0; i < numParticles; ++i) {
-        particles.posX[i] += particles.velX[i] * dt;
-        particles.posY[i] += particles.velY[i] * dt;
-        
-        particles.velX[i] *= config.damping;
-        particles.velY[i] *= config.damping;
+
+    // Planet forces switch on and off at the 20-unit cutoff and at the
+    // planet's surface (asteroids pass through planets unless accretion is
+    // on): a step must not carry a particle across either edge between kicks
+    const PlanetSystem& planets = particles.planets;
+    float x = particles.posX[i], y = particles.posY[i];
+    forEachPlanetNear(x, y, x, y, [&](int p) {
+        float dx = planets.x[p] - x, dy = planets.y[p] - y;
+        float dvx = particles.velX[i] - planets.vx[p], dvy = particles.velY[i] - planets.vy[p];
+        float speed = std::sqrt(dvx*dvx + dvy*dvy);
+        float reach = speed * limit;
+        float dist = std::sqrt(dx*dx + dy*dy);
+        float gap = std::min(std::fabs(dist - PLANET_CUTOFF), std::fabs(dist - planets.radius[p]));
+        if (nearEdge && gap < 2.0f * reach) *nearEdge = true;
+        if (gap < reach) limit = gap / speed;
+    });
+
+    int bin = 0;
+    float step = tickDt * 2.0f;
+    while (bin < maxBin && step <= limit) {
+        bin++;
+        step *= 2.0f;
     }
+    return bin;
 }
 
-int ParticleKinematics::getGridIndex(float x, float y) {
-    int cx = static_cast<int>(x / CELL_SIZE);
-    int cy = static_cast<int>(y / CELL_SIZE);
-    
-    cx = std::max(0, std::min(cx, gridWidth - 1));
-    cy = std::max(0, std::min(cy, gridHeight - 1));
-    
-    return cy * gridWidth + cx;
+void ParticleKinematics::applyInterParticleGravity(const SimConfig& config, float dt) {
+    // Tree is rebuilt every substep from the current positions: O(N log N)
+    gravityTree.build(particles.posX.data(), particles.posY.data(), numParticles);
+
+    const float softeningSq = 1.0f;
+    float gdt = config.interParticleG * dt;
+
+    // Tree is read-only during traversal
+    jobs.parallelFor(numParticles, PARALLEL_GRAIN / 4, [&](int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            float ax, ay;
+            gravityTree.computeAcceleration(particles.posX[i], particles.posY[i],
+                                            config.barnesHutTheta, softeningSq, ax, ay);
+            particles.velX[i] += ax * gdt;
+            particles.velY[i] += ay * gdt;
+        }
+    });
+}
+
+void ParticleKinematics::movePlanets(float dt) {
+    PlanetSystem& planets = particles.planets;
+    for (size_t i = 0; i < planets.size(); ++i) {
+        planets.x[i] += planets.vx[i] * dt;
+        planets.y[i] += planets.vy[i] * dt;
+    }
+}
+
+void ParticleKinematics::bouncePlanets() {
+    PlanetSystem& planets = particles.planets;
+    for (size_t i = 0; i < planets.size(); ++i) {
+        if (planets.x[i] < planets.radius[i] || planets.x[i] > boxWidth - planets.radius[i]) planets.vx[i] *= -1.0f;
+        if (planets.y[i] < planets.radius[i] || planets.y[i] > boxHeight - planets.radius[i]) planets.vy[i] *= -1.0f;
+    }
+}
+
+void ParticleKinematics::updatePositions(const SimConfig& config, float dt) {
+    movePlanets(dt);
+    jobs.parallelFor(numParticles, PARALLEL_GRAIN, [&](int begin, int end) {
+        simd.integrate(particles.posX.data(), particles.posY.data(),
+                       particles.velX.data(), particles.velY.data(),
+                       begin, end, dt, config.damping);
+    });
+}
+
+void ParticleKinematics::reorderParticles() {
+    grid.mortonOrder(particles.posX.data(), particles.posY.data(), numParticles, reorderScratch);
+
+    // Apply the same permutation to all SoA arrays
+    floatScratch.resize(numParticles);
+    for (std::vector<float>* arr : {&particles.posX, &particles.posY, &particles.velX, &particles.velY}) {
+        const float* src = arr->data();
+        for (int i = 0; i < numParticles; ++i) {
+            floatScratch[i] = src[reorderScratch[i]];
+        }
+        std::copy(floatScratch.begin(), floatScratch.end(), arr->begin());
+    }
+
+    // Block-step accelerations follow their bodies instead of being recomputed
+    bool keepAcc = accLayout == layoutVersion;
+    if (keepAcc) {
+        for (std::vector<float>* arr : {&accX, &accY}) {
+            const float* src = arr->data();
+            for (int i = 0; i < numParticles; ++i) {
+                floatScratch[i] = src[reorderScratch[i]];
+            }
+            std::copy(floatScratch.begin(), floatScratch.end(), arr->begin());
+        }
+    }
+    layoutVersion++;
+    if (keepAcc) accLayout = layoutVersion;
 }
 
 void ParticleKinematics::resolveCollisionsGrid(const SimConfig& config) {
-    for (auto& cell : grid) cell.clear();
-    for (int i = 0; i < numParticles; ++i) {
-        grid[getGridIndex(particles.posX[i], particles.posY[i])].push_back(i);
-    }
-
-    float minDist = config.collisionRadius * 2.0f;
-    float minDistSq = minDist * minDist;
-
-    for (int y = 0; y < gridHeight; ++y) {
-        for (int x = 0; x < gridWidth; ++x) {
-            int cellIdx = y * gridWidth + x;
-            int neighborOffsets[5][2] = {{0, 0}, {1, 0}, {-1, 1}, {0, 1}, {1, 1}};
-
-            for (auto& offset : neighborOffsets) {
-                int nx = x + offset[0];
-                int ny = y + offset[1];
-
-                if (nx >= 0 && nx < gridWidth && ny >= 0 && ny < gridHeight) {
-                    int neighborIdx = ny * gridWidth + nx;
-                    for (int i : grid[cellIdx]) {
-                        for (int j : grid[neighborIdx]) {
-                            if (i >= j) continue; 
-                            float dx = particles.posX[i] - particles.posX[j];
-                            float dy = particles.posY[i] - particles.posY[j];
-                            float distSq = dx*dx + dy*dy;
-                            if (distSq < minDistSq && distSq > 0.0001f) {
-                                float dist = std::sqrt(distSq);
-                                float overlap = (minDist - dist) * 0.5f;
-                                float nx = dx / dist; float ny = dy / dist;
-                                particles.posX[i] += nx * overlap; particles.posY[i] += ny * overlap;
-                                particles.posX[j] -= nx * overlap; particles.posY[j] -= ny * overlap;
-                                float dvx = particles.velX[i] - particles.velX[j];
-                                float dvy = particles.velY[i] - particles.velY[j];
-                                float velNormal = dvx * nx + dvy * ny;
-                                if (velNormal < 0) {
-                                    float impulse = -(1.0f + config.restitution) * velNormal * 0.5f;
-                                    particles.velX[i] += impulse * nx; particles.velY[i] += impulse * ny;
-                                    particles.velX[j] -= impulse * nx; particles.velY[j] -= impulse * ny;
-                                }
-                            }
-                        }
-                    }
+    if (config.verletSkin > 0.0f) {
+        resolvePairList(config);
+        return;
+    }
+
+    // Touching bodies are at most one cell apart, so the cell follows the radius
+    float cellSize = std::max(config.collisionRadius * 2.0f, MIN_COLLISION_CELL);
+    collisionHash.build(particles.posX.data(), particles.posY.data(), numParticles, cellSize, COLOR_BLOCK);
+    CollisionContext ctx = collisionContext(particles, config);
+
+    if (!config.parallelCollisions) {
+        // Single Gauss-Seidel sweep over the occupied cells
+        for (int c : collisionHash.cellOrder) {
+            collisionCount += static_cast<uint64_t>(resolveCellPairs(collisionHash, ctx, c));
+        }
+        return;
+    }
+
+    // Cell coloring: blocks of COLOR_BLOCK x COLOR_BLOCK cells get one of 4
+    // colors in a 2x2 checkerboard. A cell's stencil reaches one cell left,
+    // right and down, so same-colored blocks (COLOR_BLOCK cells apart) never
+    // touch the same particle and can run concurrently. Colors run in a
+    // fixed order and each block is swept serially, so the result does not
+    // depend on the thread count or scheduling. Only occupied blocks exist.
+    const std::vector<int>& blockStart = collisionHash.blockStart;
+    const std::vector<int>& cellOrder = collisionHash.cellOrder;
+
+    std::atomic<uint64_t> impacts{0};
+    for (int color = 0; color < 4; ++color) {
+        int firstBlock = collisionHash.colorStart[color];
+        int blockCount = collisionHash.colorStart[color + 1] - firstBlock;
+
+        jobs.parallelFor(blockCount, 4, [&](int begin, int end) {
+            uint64_t chunkImpacts = 0;
+            for (int b = firstBlock + begin; b < firstBlock + end; ++b) {
+                for (int k = blockStart[b]; k < blockStart[b + 1]; ++k) {
+                    chunkImpacts += static_cast<uint64_t>(resolveCellPairs(collisionHash, ctx, cellOrder[k]));
                 }
             }
+            impacts.fetch_add(chunkImpacts, std::memory_order_relaxed);
+        });
+    }
+    collisionCount += impacts.load();
+}
+
+bool ParticleKinematics::pairListStale(const SimConfig& config) {
+    float cutoff = config.collisionRadius * 2.0f + config.verletSkin;
+    if (pairListLayout != layoutVersion || static_cast<int>(pairRefX.size()) != numParticles ||
+        cutoff != pairListCutoff) {
+        return true;
+    }
+
+    // While no body has moved more than half the skin since the build, any
+    // two that touch now were within the cutoff then, so they are listed
+    const float limit = config.verletSkin * 0.5f;
+    const float limitSq = limit * limit;
+    std::atomic<bool> moved{false};
+    jobs.parallelFor(numParticles, PARALLEL_GRAIN, [&](int begin, int end) {
+        if (moved.load(std::memory_order_relaxed)) return;
+        for (int i = begin; i < end; ++i) {
+            float dx = particles.posX[i] - pairRefX[i];
+            float dy = particles.posY[i] - pairRefY[i];
+            if (dx*dx + dy*dy > limitSq) {
+                moved.store(true, std::memory_order_relaxed);
+                return;
+            }
+        }
+    });
+    return moved.load();
+}
+
+void ParticleKinematics::buildPairList(const SimConfig& config) {
+    const float cutoff = config.collisionRadius * 2.0f + config.verletSkin;
+    const float cutoffSq = cutoff * cutoff;
+    const float* posX = particles.posX.data();
+    const float* posY = particles.posY.data();
+    collisionHash.build(posX, posY, numParticles, std::max(cutoff, MIN_COLLISION_CELL), COLOR_BLOCK);
+
+    const std::vector<int>& blockStart = collisionHash.blockStart;
+    const std::vector<int>& cellOrder = collisionHash.cellOrder;
+    int blockTotal = static_cast<int>(blockStart.size()) - 1;
+    auto withinCutoff = [&](int i, int j) {
+        float dx = posX[i] - posX[j];
+        float dy = posY[i] - posY[j];
+        return dx*dx + dy*dy < cutoffSq;
+    };
+
+    // Count, then fill: each block's pairs land in its own slice, in the
+    // order the grid solver would visit them
+    pairBlockStart.assign(blockTotal + 1, 0);
+    jobs.parallelFor(blockTotal, 16, [&](int begin, int end) {
+        for (int b = begin; b < end; ++b) {
+            int count = 0;
+            for (int k = blockStart[b]; k < blockStart[b + 1]; ++k) {
+                forEachCellPair(collisionHash, cellOrder[k], [&](int i, int j) { count += withinCutoff(i, j); });
+            }
+            pairBlockStart[b + 1] = count;
+        }
+    });
+    for (int b = 0; b < blockTotal; ++b) pairBlockStart[b + 1] += pairBlockStart[b];
+
+    pairList.resize(pairBlockStart[blockTotal]);
+    jobs.parallelFor(blockTotal, 16, [&](int begin, int end) {
+        for (int b = begin; b < end; ++b) {
+            CollisionPair* out = pairList.data() + pairBlockStart[b];
+            for (int k = blockStart[b]; k < blockStart[b + 1]; ++k) {
+                forEachCellPair(collisionHash, cellOrder[k], [&](int i, int j) {
+                    if (withinCutoff(i, j)) *out++ = { i, j };
+                });
+            }
         }
+    });
+
+    std::copy(collisionHash.colorStart, collisionHash.colorStart + 5, pairColorStart);
+    pairRefX.assign(particles.posX.begin(), particles.posX.end());
+    pairRefY.assign(particles.posY.begin(), particles.posY.end());
+    pairListLayout = layoutVersion;
+    pairListCutoff = cutoff;
+    pairListBuilds++;
+}
+
+void ParticleKinematics::resolvePairList(const SimConfig& config) {
+    if (pairListStale(config)) buildPairList(config);
+    CollisionContext ctx = collisionContext(particles, config);
+
+    const CollisionPair* pairs = pairList.data();
+    if (!config.parallelCollisions) {
+        uint64_t impacts = 0;
+        for (const CollisionPair& pair : pairList) impacts += static_cast<uint64_t>(ctx.resolvePair(pair.i, pair.j));
+        collisionCount += impacts;
+        return;
+    }
+
+    // Pair indices stay fixed between builds, so the coloring argument of
+    // resolveCollisionsGrid() still holds however far bodies have drifted:
+    // same-colored blocks never share a particle
+    std::atomic<uint64_t> impacts{0};
+    for (int color = 0; color < 4; ++color) {
+        int firstBlock = pairColorStart[color];
+        int blockCount = pairColorStart[color + 1] - firstBlock;
+
+        jobs.parallelFor(blockCount, 4, [&](int begin, int end) {
+            uint64_t chunkImpacts = 0;
+            for (int p = pairBlockStart[firstBlock + begin]; p < pairBlockStart[firstBlock + end]; ++p) {
+                chunkImpacts += static_cast<uint64_t>(ctx.resolvePair(pairs[p].i, pairs[p].j));
+            }
+            impacts.fetch_add(chunkImpacts, std::memory_order_relaxed);
+        });
     }
+    collisionCount += impacts.load();
 }
 
 void ParticleKinematics::applyBoundaryConditions(const SimConfig& config) {
-    for (auto& p : particles.planets) {
-        if (p.x < p.radius || p.x > boxWidth - p.radius) p.vx *= -1.0f;
-        if (p.y < p.radius || p.y > boxHeight - p.radius) p.vy *= -1.0f;
+    bouncePlanets();
+
+    jobs.parallelFor(numParticles, PARALLEL_GRAIN, [&](int begin, int end) {
+        reflectWalls(config, begin, end);
+    });
+}
+
+void ParticleKinematics::reflectWalls(const SimConfig& config, int begin, int end) {
+    simd.reflectWalls(particles.posX.data(), particles.posY.data(), particles.velX.data(), particles.velY.data(),
+                      begin, end, config.collisionRadius, boxWidth - config.collisionRadius,
+                      config.collisionRadius, boxHeight - config.collisionRadius, config.restitution);
+}
+
+unsigned ParticleKinematics::stepFeatures(const SimConfig& config) const {
+    unsigned features = 0;
+    if (config.enableCentralGravity) features |= STEP_CENTRAL_GRAVITY;
+    if (!particles.planets.empty()) features |= STEP_PLANETS;
+    if (config.enableCollisions) features |= STEP_COLLISIONS;
+    if (config.damping != 1.0f) features |= STEP_DAMPING;
+    if (config.enableInterParticleGravity) features |= STEP_SELF_GRAVITY;
+    return features;
+}
+
+template <unsigned... Features>
+std::array<ParticleKinematics::SubstepPipeline, sizeof...(Features)>
+ParticleKinematics::makePipelines(std::integer_sequence<unsigned, Features...>) {
+    return { { &ParticleKinematics::runSubsteps<Features>... } };
+}
+
+template <unsigned Features>
+void ParticleKinematics::runSubsteps(const SimConfig& config, float dt) {
+    constexpr bool centralGravity = (Features & STEP_CENTRAL_GRAVITY) != 0;
+    constexpr bool planetGravity = (Features & STEP_PLANETS) != 0;
+    constexpr bool collisions = (Features & STEP_COLLISIONS) != 0;
+    constexpr bool damping = (Features & STEP_DAMPING) != 0;
+    constexpr bool selfGravity = (Features & STEP_SELF_GRAVITY) != 0;
+
+    float* posX = particles.posX.data();
+    float* posY = particles.posY.data();
+    float* velX = particles.velX.data();
+    float* velY = particles.velY.data();
+
+    // Without damping the velocity is unchanged, so only positions are stored
+    auto drift = [&](int begin, int end) {
+        if constexpr (damping) {
+            simd.integrate(posX, posY, velX, velY, begin, end, dt, config.damping);
+        } else {
+            simd.drift(posX, posY, velX, velY, begin, end, dt);
+        }
+    };
+
+    // Per particle every substep is kick, drift, collisions, walls, as in the
+    // textbook order, but passes are merged over FUSED_BLOCK-sized blocks so
+    // each particle crosses the memory bus as few times as possible:
+    //  - without self-gravity, nothing needs all particles between kick and
+    //    drift, so both run in one pass;
+    //  - without collisions, the walls join that pass too; with collisions,
+    //    a substep's walls are deferred to the start of the next substep's
+    //    pass (planet updates in between never read asteroids) and the last
+    //    substep's walls get a pass of their own.
+    // Planets still move after the asteroid kick, so results are identical
+    // to running every phase as a separate pass.
+    for (int s = 0; s < config.substeps; ++s) {
+        {
+            ProfileScope scope(ProfilePhase::Forces, &timings.forces);
+            applyPlanetForces(config, dt);
+        }
+
+        const bool wallsFirst = collisions && s > 0;
+        {
+            ProfileScope scope(ProfilePhase::Integration, &timings.integration);
+            forceEvaluations += static_cast<uint64_t>(numParticles);
+            jobs.parallelFor(numParticles, PARALLEL_GRAIN, [&](int begin, int end) {
+                for (int b = begin; b < end; b += FUSED_BLOCK) {
+                    int blockEnd = std::min(b + FUSED_BLOCK, end);
+                    if (wallsFirst) reflectWalls(config, b, blockEnd);
+                    if constexpr (centralGravity) {
+                        simd.centralGravity(posX, posY, velX, velY, b, blockEnd,
+                                            config.starX, config.starY, config.starMass, STAR_SOFTENING_SQ, dt);
+                    }
+                    if constexpr (planetGravity) {
+                        applyPlanetGravity(posX, posY, velX, velY, b, blockEnd, dt);
+                    }
+                    if constexpr (!selfGravity) {
+                        drift(b, blockEnd);
+                        if constexpr (!collisions) reflectWalls(config, b, blockEnd);
+                    }
+                }
+            });
+        }
+
+        if constexpr (selfGravity) {
+            {
+                ProfileScope scope(ProfilePhase::Forces, &timings.forces);
+                applyInterParticleGravity(config, dt);
+            }
+            ProfileScope scope(ProfilePhase::Integration, &timings.integration);
+            jobs.parallelFor(numParticles, PARALLEL_GRAIN, [&](int begin, int end) {
+                for (int b = begin; b < end; b += FUSED_BLOCK) {
+                    int blockEnd = std::min(b + FUSED_BLOCK, end);
+                    drift(b, blockEnd);
+                    if constexpr (!collisions) reflectWalls(config, b, blockEnd);
+                }
+            });
+        }
+        movePlanets(dt);
+
+        if constexpr (collisions) {
+            ProfileScope scope(ProfilePhase::Collisions, &timings.collisions);
+            resolveCollisionsGrid(config);
+        }
+        bouncePlanets();
     }
 
-    for (int i = 0; i < numParticles; ++i) {
-        if (particles.posX[i] < config.collisionRadius) {
-            particles.posX[i] = config.collisionRadius; particles.velX[i] *= -config.restitution;
-        } else if (particles.posX[i] > boxWidth - config.collisionRadius) {
-            particles.posX[i] = boxWidth - config.collisionRadius; particles.velX[i] *= -config.restitution;
+    if constexpr (collisions) {
+        ProfileScope scope(ProfilePhase::Boundaries, &timings.boundaries);
+        jobs.parallelFor(numParticles, PARALLEL_GRAIN, [&](int begin, int end) {
+            reflectWalls(config, begin, end);
+        });
+    }
+}
+
+bool ParticleKinematics::compactEligible(const SimConfig& config) const {
+    // Collisions, Barnes-Hut, accretion and block steps need the float arrays
+    return config.compactStorage && !config.enableCollisions && !config.enableInterParticleGravity &&
+           !config.enableAccretion && !config.blockTimesteps;
+}
+
+void ParticleKinematics::enterCompactStorage() {
+    compact.posX.resize(numParticles);
+    compact.posY.resize(numParticles);
+    compact.velX.resize(numParticles);
+    compact.velY.resize(numParticles);
+
+    jobs.parallelFor(numParticles, PARALLEL_GRAIN, [&](int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            compact.posX[i] = packPosition(particles.posX[i]);
+            compact.posY[i] = packPosition(particles.posY[i]);
+            compact.velX[i] = packVelocity(particles.velX[i]);
+            compact.velY[i] = packVelocity(particles.velY[i]);
+        }
+    });
+
+    releaseFloatArrays();
+    compactActive = true;
+    mirrorFresh = false;
+
+    std::cout << "[ParticleKinematics] Compact storage on: " << numParticles << " particles, "
+              << (static_cast<double>(numParticles) * 8.0 / (1024.0 * 1024.0)) << " MB" << std::endl;
+}
+
+void ParticleKinematics::leaveCompactStorage() {
+    syncParticles();
+    compact = CompactParticleSystem();
+    compactActive = false;
+    std::cout << "[ParticleKinematics] Compact storage off" << std::endl;
+}
+
+void ParticleKinematics::releaseFloatArrays() {
+    // swap() rather than clear(), so the memory is actually given back
+    std::vector<float>().swap(particles.posX);
+    std::vector<float>().swap(particles.posY);
+    std::vector<float>().swap(particles.velX);
+    std::vector<float>().swap(particles.velY);
+}
+
+void ParticleKinematics::releaseParticles() {
+    if (!compactActive) return;
+    releaseFloatArrays();
+    mirrorFresh = false;
+}
+
+void ParticleKinematics::copyAsteroids(ParticleSystem& out, const int* order) {
+    out.posX.resize(numParticles);
+    out.posY.resize(numParticles);
+    out.velX.resize(numParticles);
+    out.velY.resize(numParticles);
+    copyAsteroids(out.posX.data(), out.posY.data(), out.velX.data(), out.velY.data(), order);
+}
+
+void ParticleKinematics::copyAsteroids(float* posX, float* posY, float* velX, float* velY, const int* order) {
+    jobs.parallelFor(numParticles, PARALLEL_GRAIN, [&](int begin, int end) {
+        if (compactActive) {
+            for (int k = begin; k < end; ++k) {
+                int i = order ? order[k] : k;
+                posX[k] = static_cast<float>(compact.posX[i]) * COMPACT_POSITION_STEP;
+                posY[k] = static_cast<float>(compact.posY[i]) * COMPACT_POSITION_STEP;
+                velX[k] = halfToFloat(compact.velX[i]);
+                velY[k] = halfToFloat(compact.velY[i]);
+            }
+            return;
         }
-        if (particles.posY[i] < config.collisionRadius) {
-            particles.posY[i] = config.collisionRadius; particles.velY[i] *= -config.restitution;
-        } else if (particles.posY[i] > boxHeight - config.collisionRadius) {
-            particles.posY[i] = boxHeight - config.collisionRadius; particles.velY[i] *= -config.restitution;
+        for (int k = begin; k < end; ++k) {
+            int i = order ? order[k] : k;
+            posX[k] = particles.posX[i];
+            posY[k] = particles.posY[i];
+            velX[k] = particles.velX[i];
+            velY[k] = particles.velY[i];
         }
+    });
+}
+
+void ParticleKinematics::syncParticles() {
+    if (!compactActive || mirrorFresh) return;
+
+    particles.posX.resize(numParticles);
+    particles.posY.resize(numParticles);
+    particles.velX.resize(numParticles);
+    particles.velY.resize(numParticles);
+
+    jobs.parallelFor(numParticles, PARALLEL_GRAIN, [&](int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            particles.posX[i] = static_cast<float>(compact.posX[i]) * COMPACT_POSITION_STEP;
+            particles.posY[i] = static_cast<float>(compact.posY[i]) * COMPACT_POSITION_STEP;
+            particles.velX[i] = halfToFloat(compact.velX[i]);
+            particles.velY[i] = halfToFloat(compact.velY[i]);
+        }
+    });
+    mirrorFresh = true;
+}
+
+void ParticleKinematics::compactSubstep(const SimConfig& config, float dt, int substep) {
+    {
+        ProfileScope scope(ProfilePhase::Forces, &timings.forces);
+        applyPlanetForces(config, dt);
     }
-}
\ No newline at end of file
+
+    ProfileScope scope(ProfilePhase::Integration, &timings.integration);
+
+    // Same constants as runSubsteps() and applyBoundaryConditions()
+    CompactSubstep params;
+    params.centralGravity = config.enableCentralGravity;
+    params.starX = config.starX;
+    params.starY = config.starY;
+    params.starMass = config.starMass;
+    params.softeningSq = STAR_SOFTENING_SQ;
+    params.planets = planetBatch;
+    params.planetCutoffSq = PLANET_CUTOFF * PLANET_CUTOFF;
+    params.dt = dt;
+    params.damping = config.damping;
+    params.minX = config.collisionRadius;
+    params.maxX = boxWidth - config.collisionRadius;
+    params.minY = config.collisionRadius;
+    params.maxY = boxHeight - config.collisionRadius;
+    params.restitution = config.restitution;
+    params.positionStep = COMPACT_POSITION_STEP;
+    params.ditherSeed = static_cast<uint32_t>(stepCount * static_cast<uint64_t>(config.substeps) + substep) * 0x85EBCA6Bu;
+
+    forceEvaluations += static_cast<uint64_t>(numParticles);
+    jobs.parallelFor(numParticles, PARALLEL_GRAIN, [&](int begin, int end) {
+        if (planetBatch.count < PLANET_CULL_MIN) {
+            simd.compactSubstep(compact.posX.data(), compact.posY.data(),
+                                compact.velX.data(), compact.velY.data(), begin, end, params);
+            return;
+        }
+
+        // Per-tile planet lists, as in applyPlanetGravity(); the dither hashes
+        // particle indices, so tiling does not change the result
+        NearbyPlanets nearby;
+        CompactSubstep tileParams = params;
+        for (int t = begin; t < end; t += PLANET_TILE) {
+            int tileEnd = std::min(t + PLANET_TILE, end);
+            uint16_t minX = compact.posX[t], maxX = compact.posX[t];
+            uint16_t minY = compact.posY[t], maxY = compact.posY[t];
+            for (int i = t + 1; i < tileEnd; ++i) {
+                minX = std::min(minX, compact.posX[i]); maxX = std::max(maxX, compact.posX[i]);
+                minY = std::min(minY, compact.posY[i]); maxY = std::max(maxY, compact.posY[i]);
+            }
+            tileParams.planets = nearbyPlanets(minX * COMPACT_POSITION_STEP, minY * COMPACT_POSITION_STEP,
+                                               maxX * COMPACT_POSITION_STEP, maxY * COMPACT_POSITION_STEP, nearby);
+            simd.compactSubstep(compact.posX.data(), compact.posY.data(),
+                                compact.velX.data(), compact.velY.data(), t, tileEnd, tileParams);
+        }
+    });
+
+    movePlanets(dt);
+    bouncePlanets();
+}
@@ -0,0 +1,77 @@
+#include "spatial_grid.hpp"
+#include <algorithm>
+
+namespace {
+    // Interleave the low 16 bits of x and y (x in even bits)
+    uint32_t mortonCode(uint32_t x, uint32_t y) {
+        auto spread = [](uint32_t v) {
+            v &= 0x0000FFFF;
+            v = (v | (v << 8)) & 0x00FF00FF;
+            v = (v | (v << 4)) & 0x0F0F0F0F;
+            v = (v | (v << 2)) & 0x33333333;
+            v = (v | (v << 1)) & 0x55555555;
+            return v;
+        };
+        return spread(x) | (spread(y) << 1);
+    }
+}
+
+void SpatialGrid::resize(int w, int h, float cellSize) {
+    width = w;
+    height = h;
+    invCellSize = 1.0f / cellSize;
+
+    int cells = width * height;
+    cellStart.assign(cells, 0);
+    cellCount.assign(cells, 0);
+    cursor.assign(cells, 0);
+
+    // Order the cells along the Z-order curve once; reorders then become a
+    // counting sort over cells instead of a comparison sort over particles.
+    mortonCell.resize(cells);
+    for (int c = 0; c < cells; ++c) mortonCell[c] = c;
+    std::sort(mortonCell.begin(), mortonCell.end(), [this](int a, int b) {
+        return mortonCode(a % width, a / width) < mortonCode(b % width, b / width);
+    });
+}
+
+void SpatialGrid::countParticles(const float* posX, const float* posY, int count) {
+    std::fill(cellCount.begin(), cellCount.end(), 0);
+    particleCell.resize(count);
+    for (int i = 0; i < count; ++i) {
+        int c = cellIndex(posX[i], posY[i]);
+        particleCell[i] = c;
+        cellCount[c]++;
+    }
+}
+
+void SpatialGrid::build(const float* posX, const float* posY, int count) {
+    countParticles(posX, posY, count);
+
+    int offset = 0;
+    for (size_t c = 0; c < cellCount.size(); ++c) {
+        cellStart[c] = offset;
+        cursor[c] = offset;
+        offset += cellCount[c];
+    }
+
+    sortedIndices.resize(count);
+    for (int i = 0; i < count; ++i) {
+        sortedIndices[cursor[particleCell[i]]++] = i;
+    }
+}
+
+void SpatialGrid::mortonOrder(const float* posX, const float* posY, int count, std::vector<int>& order) {
+    countParticles(posX, posY, count);
+
+    int offset = 0;
+    for (int cell : mortonCell) {
+        cursor[cell] = offset;
+        offset += cellCount[cell];
+    }
+
+    order.resize(count);
+    for (int i = 0; i < count; ++i) {
+        order[cursor[particleCell[i]]++] = i;
+    }
+}
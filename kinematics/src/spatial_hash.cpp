@@ -0,0 +1,168 @@
+#include "spatial_hash.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    constexpr uint64_t EMPTY_KEY = ~0ull;
+    constexpr int64_t COORD_BIAS = 1ll << 30; // Keeps both packed halves below 0xFFFFFFFF
+
+    uint64_t packKey(int x, int y) {
+        return (static_cast<uint64_t>(x + COORD_BIAS) << 32) | static_cast<uint64_t>(y + COORD_BIAS);
+    }
+
+    size_t slotOf(uint64_t key, size_t mask) {
+        uint64_t h = key * 0x9E3779B97F4A7C15ull;
+        return static_cast<size_t>(h ^ (h >> 32)) & mask;
+    }
+
+    int floorDiv(int a, int b) {
+        return a >= 0 ? a / b : -((-a + b - 1) / b);
+    }
+}
+
+// --- Table ---
+
+void SpatialHash::Table::reset(size_t expected) {
+    size_t capacity = 64;
+    while (capacity < expected * 2) capacity <<= 1;
+    if (keys.size() != capacity) {
+        keys.assign(capacity, EMPTY_KEY);
+        values.resize(capacity);
+    } else {
+        std::fill(keys.begin(), keys.end(), EMPTY_KEY);
+    }
+    mask = capacity - 1;
+    used = 0;
+}
+
+int SpatialHash::Table::find(uint64_t key) const {
+    for (size_t slot = slotOf(key, mask);; slot = (slot + 1) & mask) {
+        if (keys[slot] == key) return values[slot];
+        if (keys[slot] == EMPTY_KEY) return -1;
+    }
+}
+
+int SpatialHash::Table::insert(uint64_t key, int value, bool& inserted) {
+    // Load factor stays at or below 1/2, so probes stay short
+    if ((used + 1) * 2 > keys.size()) grow();
+    for (size_t slot = slotOf(key, mask);; slot = (slot + 1) & mask) {
+        if (keys[slot] == key) {
+            inserted = false;
+            return values[slot];
+        }
+        if (keys[slot] == EMPTY_KEY) {
+            keys[slot] = key;
+            values[slot] = value;
+            used++;
+            inserted = true;
+            return value;
+        }
+    }
+}
+
+void SpatialHash::Table::grow() {
+    std::vector<uint64_t> oldKeys;
+    std::vector<int> oldValues;
+    oldKeys.swap(keys);
+    oldValues.swap(values);
+    keys.assign(oldKeys.size() * 2, EMPTY_KEY);
+    values.resize(oldValues.size() * 2);
+    mask = keys.size() - 1;
+    for (size_t i = 0; i < oldKeys.size(); ++i) {
+        if (oldKeys[i] == EMPTY_KEY) continue;
+        size_t slot = slotOf(oldKeys[i], mask);
+        while (keys[slot] != EMPTY_KEY) slot = (slot + 1) & mask;
+        keys[slot] = oldKeys[i];
+        values[slot] = oldValues[i];
+    }
+}
+
+// --- SpatialHash ---
+
+void SpatialHash::build(const float* posX, const float* posY, int count, float cellSize, int blockSize) {
+    const float invCellSize = 1.0f / cellSize;
+
+    // 1. Occupied cells, in order of first appearance
+    cells.clear();
+    cellTable.reset(lastCells);
+    particleCell.resize(count);
+    for (int i = 0; i < count; ++i) {
+        int x = static_cast<int>(std::floor(posX[i] * invCellSize));
+        int y = static_cast<int>(std::floor(posY[i] * invCellSize));
+        bool inserted;
+        int c = cellTable.insert(packKey(x, y), static_cast<int>(cells.size()), inserted);
+        if (inserted) cells.push_back({ x, y, 0, 0 });
+        cells[c].count++;
+        particleCell[i] = c;
+    }
+    int cellTotal = static_cast<int>(cells.size());
+
+    // 2. Blocks of occupied cells and their colors
+    blockTable.reset(lastBlocks);
+    blockColor.clear();
+    blockCursor.clear();
+    cellBlock.resize(cellTotal);
+    for (int c = 0; c < cellTotal; ++c) {
+        int bx = floorDiv(cells[c].x, blockSize);
+        int by = floorDiv(cells[c].y, blockSize);
+        bool inserted;
+        int b = blockTable.insert(packKey(bx, by), static_cast<int>(blockColor.size()), inserted);
+        if (inserted) {
+            blockColor.push_back((bx & 1) | ((by & 1) << 1));
+            blockCursor.push_back(0);
+        }
+        blockCursor[b]++;
+        cellBlock[c] = b;
+    }
+    int blockTotal = static_cast<int>(blockColor.size());
+
+    // 3. Blocks ranked by color, then cells grouped by block rank
+    int colorCount[4] = {};
+    for (int color : blockColor) colorCount[color]++;
+    colorStart[0] = 0;
+    for (int k = 0; k < 4; ++k) colorStart[k + 1] = colorStart[k] + colorCount[k];
+
+    int colorCursor[4] = { colorStart[0], colorStart[1], colorStart[2], colorStart[3] };
+    blockRank.resize(blockTotal);
+    blockStart.assign(blockTotal + 1, 0);
+    for (int b = 0; b < blockTotal; ++b) {
+        blockRank[b] = colorCursor[blockColor[b]]++;
+        blockStart[blockRank[b] + 1] = blockCursor[b];
+    }
+    for (int r = 0; r < blockTotal; ++r) {
+        blockStart[r + 1] += blockStart[r];
+        blockCursor[r] = blockStart[r];
+    }
+
+    cellOrder.resize(cellTotal);
+    for (int c = 0; c < cellTotal; ++c) {
+        cellOrder[blockCursor[blockRank[cellBlock[c]]]++] = c;
+    }
+
+    // 4. Particles laid out in cell order, so a block's particles are contiguous
+    cursor.resize(cellTotal);
+    int offset = 0;
+    for (int c : cellOrder) {
+        cells[c].start = offset;
+        cursor[c] = offset;
+        offset += cells[c].count;
+    }
+    sortedIndices.resize(count);
+    for (int i = 0; i < count; ++i) {
+        sortedIndices[cursor[particleCell[i]]++] = i;
+    }
+
+    lastCells = cells.size();
+    lastBlocks = blockColor.size();
+}
+
+int SpatialHash::find(int x, int y) const {
+    return cellTable.find(packKey(x, y));
+}
+
+size_t SpatialHash::memoryBytes() const {
+    return cellTable.memoryBytes() + blockTable.memoryBytes() +
+           cells.capacity() * sizeof(Cell) + sortedIndices.capacity() * sizeof(int) +
+           (cellOrder.capacity() + blockStart.capacity() + particleCell.capacity() + cellBlock.capacity() +
+            blockColor.capacity() + blockRank.capacity() + blockCursor.capacity() + cursor.capacity()) * sizeof(int);
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Hot-path instrumentation. Scoped timers push samples into fixed-size
+// lock-free rings: one history ring per phase (for rolling stats and the
+// ImGui graph) and one shared event ring (for Chrome trace export).
+// Recording never allocates, locks or blocks.
+
+enum class ProfilePhase : uint8_t {
+    Step = 0,      // Whole ParticleKinematics::step
+    Forces,
+    Integration,
+    Collisions,
+    Boundaries,
+    Reorder,
+    Rasterize,     // updateBuffer
+    Interface,     // ImGui frame build
+    Present,
+    Count
+};
+
+const char* profilePhaseName(ProfilePhase phase);
+
+struct ProfileStats {
+    float minMs = 0.0f;
+    float avgMs = 0.0f;
+    float p99Ms = 0.0f;
+    float lastMs = 0.0f;
+    int samples = 0;
+};
+
+class Profiler {
+    public:
+        static constexpr int HISTORY_SIZE = 256;   // Samples kept per phase
+        static constexpr int EVENT_CAPACITY = 1 << 16; // Trace events kept in total
+
+        static Profiler& instance();
+        static uint64_t nowNs();
+
+        void setEnabled(bool on) { enabled.store(on, std::memory_order_relaxed); }
+        bool isEnabled() const { return enabled.load(std::memory_order_relaxed); }
+
+        // Safe from any thread. Each phase is expected to be timed from one thread.
+        void record(ProfilePhase phase, uint64_t startNs, uint64_t durationNs);
+
+        // Rolling statistics over the phase history
+        ProfileStats stats(ProfilePhase phase) const;
+
+        // Copies the history (oldest first, in ms) and returns the sample count
+        int history(ProfilePhase phase, float* out, int maxCount) const;
+
+        // Writes the event ring as Chrome trace-event JSON (chrome://tracing, Perfetto)
+        bool dumpChromeTrace(const std::string& path) const;
+
+    private:
+        Profiler() = default;
+
+        struct PhaseHistory {
+            std::atomic<float> samples[HISTORY_SIZE];
+            std::atomic<uint32_t> writeIndex{0};
+        };
+
+        // A slot is valid when sequence == its event index + 1; the writer
+        // publishes the sequence last, so readers can detect torn slots.
+        struct TraceEvent {
+            std::atomic<uint64_t> sequence{0};
+            std::atomic<uint64_t> startNs{0};
+            std::atomic<uint64_t> durationNs{0};
+            std::atomic<uint32_t> threadId{0};
+            std::atomic<uint8_t> phase{0};
+        };
+
+        std::atomic<bool> enabled{true};
+        PhaseHistory phases[static_cast<int>(ProfilePhase::Count)];
+        TraceEvent events[EVENT_CAPACITY];
+        std::atomic<uint64_t> eventCounter{0};
+};
+
+// Times its own lifetime. Optionally also adds the elapsed seconds to `total`.
+class ProfileScope {
+    public:
+        explicit ProfileScope(ProfilePhase phase, double* total = nullptr)
+            : phase(phase), total(total), start(Profiler::nowNs()) {}
+        ~ProfileScope() {
+            uint64_t duration = Profiler::nowNs() - start;
+            if (total) *total += duration * 1e-9;
+            Profiler::instance().record(phase, start, duration);
+        }
+
+        ProfileScope(const ProfileScope&) = delete;
+        ProfileScope& operator=(const ProfileScope&) = delete;
+
+    private:
+        ProfilePhase phase;
+        double* total;
+        uint64_t start;
+};
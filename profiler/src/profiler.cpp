@@ -0,0 +1,125 @@
+#include "profiler.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+namespace {
+    const char* const PHASE_NAMES[] = {
+        "step", "forces", "integration", "collisions", "boundaries", "reorder",
+        "rasterize", "interface", "present"
+    };
+    static_assert(sizeof(PHASE_NAMES) / sizeof(PHASE_NAMES[0]) == static_cast<size_t>(ProfilePhase::Count),
+                  "Every ProfilePhase needs a name");
+
+    // Small, stable per-thread ids for the trace viewer
+    uint32_t currentThreadId() {
+        static std::atomic<uint32_t> nextId{1};
+        thread_local uint32_t id = nextId.fetch_add(1, std::memory_order_relaxed);
+        return id;
+    }
+}
+
+const char* profilePhaseName(ProfilePhase phase) {
+    return PHASE_NAMES[static_cast<int>(phase)];
+}
+
+Profiler& Profiler::instance() {
+    static Profiler profiler;
+    return profiler;
+}
+
+uint64_t Profiler::nowNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void Profiler::record(ProfilePhase phase, uint64_t startNs, uint64_t durationNs) {
+    if (!enabled.load(std::memory_order_relaxed)) return;
+
+    // 1. Phase history (single producer per phase)
+    PhaseHistory& h = phases[static_cast<int>(phase)];
+    uint32_t w = h.writeIndex.load(std::memory_order_relaxed);
+    h.samples[w % HISTORY_SIZE].store(durationNs * 1e-6f, std::memory_order_relaxed);
+    h.writeIndex.store(w + 1, std::memory_order_release);
+
+    // 2. Trace event (any number of producers claim slots by counter)
+    uint64_t index = eventCounter.fetch_add(1, std::memory_order_relaxed);
+    TraceEvent& e = events[index % EVENT_CAPACITY];
+    e.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    e.startNs.store(startNs, std::memory_order_relaxed);
+    e.durationNs.store(durationNs, std::memory_order_relaxed);
+    e.threadId.store(currentThreadId(), std::memory_order_relaxed);
+    e.phase.store(static_cast<uint8_t>(phase), std::memory_order_relaxed);
+    e.sequence.store(index + 1, std::memory_order_release);
+}
+
+int Profiler::history(ProfilePhase phase, float* out, int maxCount) const {
+    const PhaseHistory& h = phases[static_cast<int>(phase)];
+    uint32_t w = h.writeIndex.load(std::memory_order_acquire);
+    int count = static_cast<int>(std::min<uint32_t>(w, HISTORY_SIZE));
+    count = std::min(count, maxCount);
+    for (int i = 0; i < count; ++i) {
+        out[i] = h.samples[(w - count + i) % HISTORY_SIZE].load(std::memory_order_relaxed);
+    }
+    return count;
+}
+
+ProfileStats Profiler::stats(ProfilePhase phase) const {
+    float buffer[HISTORY_SIZE];
+    int count = history(phase, buffer, HISTORY_SIZE);
+
+    ProfileStats s;
+    s.samples = count;
+    if (count == 0) return s;
+
+    s.lastMs = buffer[count - 1];
+    float sum = 0.0f;
+    s.minMs = buffer[0];
+    for (int i = 0; i < count; ++i) {
+        s.minMs = std::min(s.minMs, buffer[i]);
+        sum += buffer[i];
+    }
+    s.avgMs = sum / count;
+
+    int p99Index = std::min(count - 1, (count * 99) / 100);
+    std::nth_element(buffer, buffer + p99Index, buffer + count);
+    s.p99Ms = buffer[p99Index];
+    return s;
+}
+
+bool Profiler::dumpChromeTrace(const std::string& path) const {
+    struct Event { uint64_t start, duration; uint32_t tid; uint8_t phase; };
+    std::vector<Event> snapshot;
+
+    uint64_t end = eventCounter.load(std::memory_order_acquire);
+    uint64_t begin = end > EVENT_CAPACITY ? end - EVENT_CAPACITY : 0;
+    snapshot.reserve(end - begin);
+
+    for (uint64_t index = begin; index < end; ++index) {
+        const TraceEvent& e = events[index % EVENT_CAPACITY];
+        if (e.sequence.load(std::memory_order_acquire) != index + 1) continue; // Being written
+        Event copy = { e.startNs.load(std::memory_order_relaxed), e.durationNs.load(std::memory_order_relaxed),
+                       e.threadId.load(std::memory_order_relaxed), e.phase.load(std::memory_order_relaxed) };
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (e.sequence.load(std::memory_order_relaxed) != index + 1) continue; // Overwritten meanwhile
+        snapshot.push_back(copy);
+    }
+
+    FILE* f = std::fopen(path.c_str(), "w");
+    if (!f) return false;
+
+    uint64_t origin = snapshot.empty() ? 0 : snapshot.front().start;
+    for (const Event& e : snapshot) origin = std::min(origin, e.start);
+
+    std::fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    for (size_t i = 0; i < snapshot.size(); ++i) {
+        const Event& e = snapshot[i];
+        std::fprintf(f, "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}%s\n",
+                     PHASE_NAMES[e.phase], e.tid, (e.start - origin) * 1e-3, e.duration * 1e-3,
+                     i + 1 < snapshot.size() ? "," : "");
+    }
+    std::fprintf(f, "]}\n");
+    return std::fclose(f) == 0;
+}
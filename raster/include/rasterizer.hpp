@@ -0,0 +1,84 @@
+#pragma once
+
+#include "particle.hpp"
+#include "common.hpp"
+#include "job_system.hpp"
+#include <cstdint>
+#include <vector>
+
+// Region of the simulation box mapped onto the whole frame, in simulation units
+struct Viewport {
+    float x = 0.0f;              // Left edge
+    float y = 0.0f;              // Top edge
+    float width = SIM_WIDTH;
+    float height = SIM_HEIGHT;
+};
+
+// Reference single-threaded frame fill: clears the whole buffer, then draws
+// the star, planets and velocity-colored particles.
+void updateBuffer(std::vector<uint32_t>& buffer, const ParticleSystem& particles, int screenWidth, int screenHeight);
+
+// Parallel tiled rasterizer producing the same image as updateBuffer for the
+// full-box view. Particles are binned into screen tiles by a counting sort,
+// then tiles are shaded concurrently.
+//
+// With a cell index, binning reads only the cells the view overlaps. When
+// more than DENSITY_THRESHOLD bodies land per visible pixel, single points
+// would just overwrite each other: particles are then splatted into
+// per-pixel counts and shown log tone mapped, colored by their mean speed.
+class Rasterizer {
+    public:
+        static constexpr int TILE_SIZE = 64;
+
+        Rasterizer(int width, int height, int threadCount = 0);
+
+        static constexpr float DENSITY_THRESHOLD = 1.0f;  // Binned bodies per visible pixel
+
+        // pitch is the row stride in bytes. `cells` indexes `particles` (see
+        // ParticleCells); without it every particle is tested against the view.
+        void draw(const ParticleSystem& particles, uint32_t* pixels, int pitch,
+                  const Viewport& view = Viewport(), const ParticleCells* cells = nullptr);
+
+        int getWidth() const { return width; }
+        int getHeight() const { return height; }
+        // Last frame was drawn as density splats
+        bool isDensityMode() const { return densityMode; }
+        // Particles binned last frame (on screen, or at least in a visible cell)
+        int getBinnedCount() const { return static_cast<int>(binnedPixel.size()); }
+
+    private:
+        void binParticles(const ParticleSystem& particles, const Viewport& view, const ParticleCells* cells);
+        void accumulateTile(int tile);
+        void shadeTile(int tile, const ParticleSystem& particles, const Viewport& view, uint32_t* pixels, int stride);
+
+        int width;
+        int height;
+        int tilesX;
+        int tilesY;
+
+        JobSystem jobs;
+
+        // Velocity-squared -> ARGB color
+        static constexpr int LUT_SIZE = 256;
+        static constexpr float LUT_MAX_SPEED_SQ = 500.0f;
+        uint32_t colorLut[LUT_SIZE];
+
+        // --- Binning (counting sort by tile) ---
+        static constexpr int BIN_CHUNK = 65536;        // Particles per binning job
+        struct Span { int begin, end; };
+        std::vector<Span> binChunks;                   // Particle ranges to bin, at most BIN_CHUNK each
+        std::vector<uint32_t> particlePixel;           // Packed (y << 16 | x) per particle, UINT32_MAX = off screen
+        std::vector<int> chunkTileCounts;              // [chunk][tile] counts, then write cursors
+        std::vector<int> tileStart;                    // First entry of each tile (tileCount + 1 entries)
+        std::vector<uint32_t> binnedPixel;             // Packed (y << 16 | x) per entry
+        std::vector<uint32_t> binnedColor;             // ARGB, or the speed LUT index in density mode
+
+        // --- Density Splats ---
+        bool densityMode = false;
+        std::vector<uint32_t> densityCount;            // Bodies per pixel
+        std::vector<uint32_t> densitySpeed;            // Sum of their speed LUT indices
+        std::vector<uint32_t> tilePeak;                // Largest count per tile
+        float toneScale = 0.0f;                        // 1 / log(1 + frame peak)
+        static constexpr int TONE_LUT_SIZE = 256;
+        float toneLut[TONE_LUT_SIZE];                  // Brightness of small counts this frame
+};
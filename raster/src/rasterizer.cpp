@@ -0,0 +1,270 @@
+#include "rasterizer.hpp"
+#include "common.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    constexpr uint32_t BACKGROUND = 0xFF000000;
+    constexpr uint32_t STAR_COLOR = 0xFFFFFF00;
+    constexpr int STAR_RADIUS = 8;
+    constexpr uint32_t OFF_SCREEN = 0xFFFFFFFF;
+
+    // Filled disc clipped to the tile rectangle [x0, x1) x [y0, y1)
+    void drawDisc(uint32_t* pixels, int stride, int cx, int cy, int r, uint32_t color,
+                  int x0, int y0, int x1, int y1) {
+        int minX = std::max(cx - r, x0), maxX = std::min(cx + r, x1 - 1);
+        int minY = std::max(cy - r, y0), maxY = std::min(cy + r, y1 - 1);
+        for (int y = minY; y <= maxY; ++y) {
+            int dy = y - cy;
+            uint32_t* row = pixels + static_cast<size_t>(y) * stride;
+            for (int x = minX; x <= maxX; ++x) {
+                int dx = x - cx;
+                if (dx*dx + dy*dy <= r*r) row[x] = color;
+            }
+        }
+    }
+
+    // ARGB color with its RGB channels scaled by t in [0, 1]
+    uint32_t scaleColor(uint32_t color, float t) {
+        uint32_t r = static_cast<uint32_t>(((color >> 16) & 0xFF) * t);
+        uint32_t g = static_cast<uint32_t>(((color >> 8) & 0xFF) * t);
+        uint32_t b = static_cast<uint32_t>((color & 0xFF) * t);
+        return 0xFF000000u | (r << 16) | (g << 8) | b;
+    }
+
+    int clampCell(float v, float cellSize, int cells) {
+        int c = static_cast<int>(std::floor(v / cellSize));
+        return c < 0 ? 0 : (c >= cells ? cells - 1 : c);
+    }
+}
+
+Rasterizer::Rasterizer(int width, int height, int threadCount)
+    : width(width), height(height), jobs(threadCount) {
+    tilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+    tilesY = (height + TILE_SIZE - 1) / TILE_SIZE;
+    tileStart.assign(tilesX * tilesY + 1, 0);
+
+    // Same ramp as updateBuffer, sampled at LUT_SIZE speeds
+    for (int k = 0; k < LUT_SIZE; ++k) {
+        float t = static_cast<float>(k) / (LUT_SIZE - 1);
+        uint8_t r = static_cast<uint8_t>(t * 255);
+        uint8_t g = static_cast<uint8_t>((1.0f - t) * 150 + 50);
+        uint8_t b = static_cast<uint8_t>((1.0f - t) * 255);
+        colorLut[k] = (0xFFu << 24) | (r << 16) | (g << 8) | b;
+    }
+}
+
+void Rasterizer::binParticles(const ParticleSystem& particles, const Viewport& view, const ParticleCells* cells) {
+    int n = static_cast<int>(particles.posX.size());
+    int tileCount = tilesX * tilesY;
+
+    // 1. Particle ranges that can reach the screen, cut into BIN_CHUNK pieces:
+    //    everything, or the cells the view overlaps (one run per cell row;
+    //    runs that continue each other share chunks)
+    binChunks.clear();
+    auto addRange = [&](int begin, int end) {
+        while (begin < end) {
+            if (binChunks.empty() || binChunks.back().end != begin ||
+                binChunks.back().end - binChunks.back().begin == BIN_CHUNK) {
+                binChunks.push_back({ begin, begin });
+            }
+            Span& chunk = binChunks.back();
+            chunk.end = std::min(end, chunk.begin + BIN_CHUNK);
+            begin = chunk.end;
+        }
+    };
+
+    bool indexed = cells && cells->cellSize > 0.0f &&
+                   cells->cellStart.size() == static_cast<size_t>(cells->cellsX) * cells->cellsY + 1 &&
+                   cells->cellStart.back() == n;
+    if (indexed) {
+        // One pixel of slack: the pixel mapping truncates towards zero, so
+        // bodies up to a pixel left of or above the view still land on it
+        float padX = view.width / width, padY = view.height / height;
+        int cx0 = clampCell(view.x - padX, cells->cellSize, cells->cellsX);
+        int cx1 = clampCell(view.x + view.width + padX, cells->cellSize, cells->cellsX);
+        int cy0 = clampCell(view.y - padY, cells->cellSize, cells->cellsY);
+        int cy1 = clampCell(view.y + view.height + padY, cells->cellSize, cells->cellsY);
+        for (int cy = cy0; cy <= cy1; ++cy) {
+            const int* row = cells->cellStart.data() + static_cast<size_t>(cy) * cells->cellsX;
+            addRange(row[cx0], row[cx1 + 1]);
+        }
+    } else {
+        addRange(0, n);
+    }
+    int chunks = static_cast<int>(binChunks.size());
+
+    float scaleX = width / view.width;
+    float scaleY = height / view.height;
+    const float* posX = particles.posX.data();
+    const float* posY = particles.posY.data();
+
+    particlePixel.resize(n);
+    chunkTileCounts.assign(static_cast<size_t>(chunks) * tileCount, 0);
+
+    // 2. Pixel of every candidate, counted per tile and chunk so chunks never share counters
+    jobs.parallelFor(chunks, 1, [&](int chunkBegin, int chunkEnd) {
+        for (int chunk = chunkBegin; chunk < chunkEnd; ++chunk) {
+            int* counts = chunkTileCounts.data() + static_cast<size_t>(chunk) * tileCount;
+            for (int i = binChunks[chunk].begin; i < binChunks[chunk].end; ++i) {
+                int px = static_cast<int>((posX[i] - view.x) * scaleX);
+                int py = static_cast<int>((posY[i] - view.y) * scaleY);
+                if (px >= 0 && px < width && py >= 0 && py < height) {
+                    particlePixel[i] = (static_cast<uint32_t>(py) << 16) | static_cast<uint32_t>(px);
+                    counts[(py / TILE_SIZE) * tilesX + px / TILE_SIZE]++;
+                } else {
+                    particlePixel[i] = OFF_SCREEN;
+                }
+            }
+        }
+    });
+
+    // 3. Prefix sum in (tile, chunk) order: each tile's entries stay in particle order,
+    //    so overlapping particles resolve exactly like the serial path
+    int offset = 0;
+    for (int tile = 0; tile < tileCount; ++tile) {
+        tileStart[tile] = offset;
+        for (int chunk = 0; chunk < chunks; ++chunk) {
+            int& c = chunkTileCounts[static_cast<size_t>(chunk) * tileCount + tile];
+            int count = c;
+            c = offset;
+            offset += count;
+        }
+    }
+    tileStart[tileCount] = offset;
+
+    binnedPixel.resize(offset);
+    binnedColor.resize(offset);
+
+    // 4. Level of detail from the bodies per pixel of the box's visible part
+    float visibleW = (std::min(view.x + view.width, SIM_WIDTH) - std::max(view.x, 0.0f)) * scaleX;
+    float visibleH = (std::min(view.y + view.height, SIM_HEIGHT) - std::max(view.y, 0.0f)) * scaleY;
+    densityMode = offset > DENSITY_THRESHOLD * std::max(visibleW, 1.0f) * std::max(visibleH, 1.0f);
+
+    // 5. Scatter packed pixel coordinates and LUT colors (LUT indices for splats)
+    const float* velX = particles.velX.data();
+    const float* velY = particles.velY.data();
+    const float lutScale = (LUT_SIZE - 1) / LUT_MAX_SPEED_SQ;
+
+    jobs.parallelFor(chunks, 1, [&](int chunkBegin, int chunkEnd) {
+        for (int chunk = chunkBegin; chunk < chunkEnd; ++chunk) {
+            int* cursor = chunkTileCounts.data() + static_cast<size_t>(chunk) * tileCount;
+            for (int i = binChunks[chunk].begin; i < binChunks[chunk].end; ++i) {
+                uint32_t packed = particlePixel[i];
+                if (packed == OFF_SCREEN) continue;
+
+                int tile = ((packed >> 16) / TILE_SIZE) * tilesX + (packed & 0xFFFF) / TILE_SIZE;
+                float vSq = velX[i] * velX[i] + velY[i] * velY[i];
+                int k = std::min(LUT_SIZE - 1, static_cast<int>(vSq * lutScale));
+
+                int slot = cursor[tile]++;
+                binnedPixel[slot] = packed;
+                binnedColor[slot] = densityMode ? static_cast<uint32_t>(k) : colorLut[k];
+            }
+        }
+    });
+}
+
+void Rasterizer::accumulateTile(int tile) {
+    int x0 = (tile % tilesX) * TILE_SIZE;
+    int y0 = (tile / tilesX) * TILE_SIZE;
+    int x1 = std::min(x0 + TILE_SIZE, width);
+    int y1 = std::min(y0 + TILE_SIZE, height);
+    for (int y = y0; y < y1; ++y) {
+        size_t row = static_cast<size_t>(y) * width;
+        std::fill(densityCount.begin() + row + x0, densityCount.begin() + row + x1, 0u);
+        std::fill(densitySpeed.begin() + row + x0, densitySpeed.begin() + row + x1, 0u);
+    }
+
+    uint32_t peak = 0;
+    for (int k = tileStart[tile]; k < tileStart[tile + 1]; ++k) {
+        uint32_t packed = binnedPixel[k];
+        size_t p = static_cast<size_t>(packed >> 16) * width + (packed & 0xFFFF);
+        peak = std::max(peak, ++densityCount[p]);
+        densitySpeed[p] += binnedColor[k];
+    }
+    tilePeak[tile] = peak;
+}
+
+void Rasterizer::shadeTile(int tile, const ParticleSystem& particles, const Viewport& view, uint32_t* pixels, int stride) {
+    int x0 = (tile % tilesX) * TILE_SIZE;
+    int y0 = (tile / tilesX) * TILE_SIZE;
+    int x1 = std::min(x0 + TILE_SIZE, width);
+    int y1 = std::min(y0 + TILE_SIZE, height);
+
+    // 1. Background: splats cover every pixel, otherwise clear the tile
+    if (densityMode) {
+        for (int y = y0; y < y1; ++y) {
+            uint32_t* row = pixels + static_cast<size_t>(y) * stride;
+            const uint32_t* count = densityCount.data() + static_cast<size_t>(y) * width;
+            const uint32_t* speed = densitySpeed.data() + static_cast<size_t>(y) * width;
+            for (int x = x0; x < x1; ++x) {
+                uint32_t c = count[x];
+                if (c == 0) {
+                    row[x] = BACKGROUND;
+                    continue;
+                }
+                float t = c < TONE_LUT_SIZE ? toneLut[c] : std::log1p(static_cast<float>(c)) * toneScale;
+                row[x] = scaleColor(colorLut[speed[x] / c], t);
+            }
+        }
+    } else {
+        for (int y = y0; y < y1; ++y) {
+            uint32_t* row = pixels + static_cast<size_t>(y) * stride;
+            std::fill(row + x0, row + x1, BACKGROUND);
+        }
+    }
+
+    float scaleX = width / view.width;
+    float scaleY = height / view.height;
+    float zoom = SIM_WIDTH / view.width;
+
+    // 2. Star at the domain center
+    int starX = static_cast<int>((SIM_WIDTH / 2.0f - view.x) * scaleX);
+    int starY = static_cast<int>((SIM_HEIGHT / 2.0f - view.y) * scaleY);
+    drawDisc(pixels, stride, starX, starY, static_cast<int>(STAR_RADIUS * zoom), STAR_COLOR, x0, y0, x1, y1);
+
+    // 3. Planets
+    const PlanetSystem& planets = particles.planets;
+    for (size_t p = 0; p < planets.size(); ++p) {
+        int pr = std::max(2, static_cast<int>(planets.radius[p] * (scaleX / 5.0f)));
+        drawDisc(pixels, stride, static_cast<int>((planets.x[p] - view.x) * scaleX),
+                 static_cast<int>((planets.y[p] - view.y) * scaleY), pr, planets.color[p], x0, y0, x1, y1);
+    }
+
+    // 4. Particles binned into this tile
+    int begin = tileStart[tile];
+    int end = tileStart[tile + 1];
+    if (!densityMode) {
+        for (int k = begin; k < end; ++k) {
+            uint32_t packed = binnedPixel[k];
+            pixels[static_cast<size_t>(packed >> 16) * stride + (packed & 0xFFFF)] = binnedColor[k];
+        }
+    }
+}
+
+void Rasterizer::draw(const ParticleSystem& particles, uint32_t* pixels, int pitch,
+                      const Viewport& view, const ParticleCells* cells) {
+    binParticles(particles, view, cells);
+    int tileCount = tilesX * tilesY;
+
+    // Splat counts need the frame's peak before any tile can be tone mapped
+    if (densityMode) {
+        densityCount.resize(static_cast<size_t>(width) * height);
+        densitySpeed.resize(static_cast<size_t>(width) * height);
+        tilePeak.resize(tileCount);
+        jobs.parallelFor(tileCount, 1, [&](int begin, int end) {
+            for (int tile = begin; tile < end; ++tile) accumulateTile(tile);
+        });
+        uint32_t peak = *std::max_element(tilePeak.begin(), tilePeak.end());
+        toneScale = 1.0f / std::log1p(static_cast<float>(std::max(peak, 1u)));
+        for (int c = 0; c < TONE_LUT_SIZE; ++c) toneLut[c] = std::min(1.0f, std::log1p(static_cast<float>(c)) * toneScale);
+    }
+
+    int stride = pitch / static_cast<int>(sizeof(uint32_t));
+    jobs.parallelFor(tileCount, 1, [&](int begin, int end) {
+        for (int tile = begin; tile < end; ++tile) {
+            shadeTile(tile, particles, view, pixels, stride);
+        }
+    });
+}
@@ -0,0 +1,154 @@
+#pragma once
+
+#include "particle.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+// Compressed per-frame trajectory file.
+//
+//   TrajectoryHeader | chunk | chunk | ...
+//   chunk = TrajectoryChunkHeader | frame | frame | ...
+//   frame = TrajectoryFrameHeader | planet records | x stream | y stream | color stream
+//
+// Positions are quantized to positionBits (at most 16) over the domain. The
+// first frame of a chunk (the keyframe) stores each particle relative to the previous particle,
+// which is small after the Z-order sort; later frames store the residual of a
+// linear prediction from the two previous frames. Residuals are zigzag coded
+// and bit-packed in blocks of BLOCK_SIZE with one width byte per block.
+// Colors are the rasterizer's speed LUT index, delta coded the same way.
+//
+// A chunk never spans a change of particle count or index layout, so every
+// chunk decodes on its own.
+
+constexpr uint32_t TRAJECTORY_VERSION = 1;
+constexpr int TRAJECTORY_CHUNK_FRAMES = 64;     // Upper bound; layout changes end chunks earlier
+constexpr int TRAJECTORY_BLOCK_SIZE = 64;      // Values per bit-packed block
+constexpr int TRAJECTORY_COLOR_LEVELS = 256;
+constexpr int TRAJECTORY_POSITION_BITS = 14;    // ~0.02 units: well below a pixel even zoomed in
+constexpr float TRAJECTORY_MAX_SPEED_SQ = 500.0f; // Speed squared mapped to the top color level
+
+struct TrajectoryHeader {
+    char magic[8];              // "PSIMTRAJ"
+    uint32_t version;
+    uint32_t headerSize;
+    float domainWidth;
+    float domainHeight;
+    float frameDt;              // Simulated seconds per frame index
+    float maxSpeedSq;
+    uint32_t colorLevels;
+    uint32_t positionBits;
+    uint8_t reserved[24];
+};
+static_assert(sizeof(TrajectoryHeader) == 64, "Header layout is part of the file format");
+
+struct TrajectoryChunkHeader {
+    uint32_t magic;             // "CHNK"
+    uint32_t frameCount;
+    uint32_t particleCount;
+    uint32_t payloadBytes;      // Frames following this header
+    uint64_t firstFrame;
+    uint64_t lastFrame;
+};
+
+struct TrajectoryFrameHeader {
+    uint64_t frame;
+    uint32_t planetCount;
+    uint32_t payloadBytes;      // Planets and streams following this header
+};
+
+struct TrajectoryPlanet {
+    float x, y;
+    float radius;
+    uint32_t color;
+};
+
+// One captured simulation frame, as handed to the writer
+struct TrajectoryFrameView {
+    const float* posX;
+    const float* posY;
+    const float* velX;
+    const float* velY;
+    int count;
+    const PlanetSystem* planets;
+    uint64_t frame;
+    uint64_t layoutVersion;
+};
+
+class TrajectoryWriter {
+    public:
+        TrajectoryWriter() = default;
+        ~TrajectoryWriter();
+
+        TrajectoryWriter(const TrajectoryWriter&) = delete;
+        TrajectoryWriter& operator=(const TrajectoryWriter&) = delete;
+
+        bool open(const char* path, float frameDt, int positionBits = TRAJECTORY_POSITION_BITS);
+        bool write(const TrajectoryFrameView& view);
+        bool close();   // Flushes the open chunk
+        bool isOpen() const { return file != nullptr; }
+
+        uint64_t bytesWritten() const { return totalBytes; }
+        uint64_t framesWritten() const { return totalFrames; }
+
+    private:
+        bool flushChunk();
+
+        FILE* file = nullptr;
+        float quantMax = 0.0f;
+        uint64_t totalBytes = 0;
+        uint64_t totalFrames = 0;
+
+        // --- Open chunk ---
+        TrajectoryChunkHeader chunk = {};
+        uint64_t chunkLayout = 0;
+        std::vector<uint8_t> chunkPayload;
+
+        // --- Prediction history (quantized, exactly what the decoder sees) ---
+        std::vector<uint16_t> prevX[2], prevY[2];
+        std::vector<uint8_t> prevColor;
+
+        // --- Scratch ---
+        std::vector<uint16_t> qx, qy;
+        std::vector<uint8_t> qc;
+        std::vector<uint32_t> residuals;
+};
+
+// Sequential chunk reader. open() indexes the chunks so playback can restart
+// or jump without decoding what it skips.
+class TrajectoryReader {
+    public:
+        TrajectoryReader() = default;
+        ~TrajectoryReader();
+
+        TrajectoryReader(const TrajectoryReader&) = delete;
+        TrajectoryReader& operator=(const TrajectoryReader&) = delete;
+
+        bool open(const char* path);
+        void close();
+
+        const TrajectoryHeader& header() const { return fileHeader; }
+        int chunkCount() const { return static_cast<int>(chunkOffsets.size()); }
+        uint64_t firstFrame() const { return frameRange[0]; }
+        uint64_t lastFrame() const { return frameRange[1]; }
+
+        // Reads chunk `index` into memory; frames are then decoded in order
+        bool loadChunk(int index);
+        bool decodeNext(ParticleSystem& out, uint64_t& frame);
+
+    private:
+        FILE* file = nullptr;
+        TrajectoryHeader fileHeader = {};
+        std::vector<long> chunkOffsets;
+        uint64_t frameRange[2] = { 0, 0 };
+
+        // --- Loaded chunk ---
+        TrajectoryChunkHeader chunk = {};
+        std::vector<uint8_t> chunkPayload;
+        size_t cursor = 0;
+        uint32_t decodedFrames = 0;
+
+        std::vector<uint16_t> prevX[2], prevY[2];
+        std::vector<uint8_t> prevColor;
+        std::vector<uint32_t> residuals;
+};
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "trajectory.hpp"
+#include "spsc_queue.hpp"
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+// Streams a trajectory file for display without running the simulation.
+// A read-ahead thread loads and decodes chunks into a small pool of frames;
+// the UI thread advances a playback clock and picks up frames as they become
+// due, so disk and decode latency stay off the render loop.
+class TrajectoryPlayer {
+    public:
+        static constexpr int FRAME_SLOTS = 8;   // Decoded frames buffered ahead
+
+        TrajectoryPlayer() = default;
+        ~TrajectoryPlayer();
+
+        bool open(const char* path, bool loop = true);
+        void close();
+
+        // UI thread: advances playback by `seconds` x speed of simulated time
+        // (speed 0: next decoded frame). Returns true when current() changed.
+        bool advance(double seconds, float speed = 1.0f);
+
+        bool hasFrame() const { return currentSlot >= 0; }
+        const ParticleSystem& current() const { return slots[currentSlot].particles; }
+        uint64_t currentFrame() const { return slots[currentSlot].frame; }
+        uint64_t firstFrame() const { return reader.firstFrame(); }
+        uint64_t lastFrame() const { return reader.lastFrame(); }
+
+        // True once a non-looping replay has shown its last frame
+        bool finished();
+
+    private:
+        struct DecodedFrame {
+            ParticleSystem particles;
+            uint64_t frame = 0;
+            uint32_t pass = 0;      // Increments each time playback wraps around
+        };
+
+        void run();
+        bool takeReady();
+
+        TrajectoryReader reader;
+        float frameDt = 0.016f;
+        bool looping = true;
+
+        DecodedFrame slots[FRAME_SLOTS];
+        SpscQueue<int, FRAME_SLOTS> freeSlots;   // UI -> read-ahead
+        SpscQueue<int, FRAME_SLOTS> readySlots;  // Read-ahead -> UI
+
+        std::thread worker;
+        std::atomic<bool> running{false};
+        std::atomic<bool> exhausted{false};
+
+        // --- UI-thread state ---
+        int currentSlot = -1;
+        int pendingSlot = -1;
+        uint32_t currentPass = 0;
+        double clock = 0.0;         // Playback position in frame indices
+};
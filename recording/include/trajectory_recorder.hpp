@@ -0,0 +1,62 @@
+#pragma once
+
+#include "trajectory.hpp"
+#include "spsc_queue.hpp"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+// Records simulation frames to a trajectory file from a background thread.
+// capture() only copies the arrays into a free slot, so the simulation pays
+// a memcpy per frame; quantization, coding and disk I/O happen on the worker.
+// When the worker falls behind, frames are dropped rather than stalling the
+// caller (the file stays decodable, prediction just spans the gap).
+class TrajectoryRecorder {
+    public:
+        static constexpr int FRAME_SLOTS = 4;
+
+        TrajectoryRecorder() = default;
+        ~TrajectoryRecorder();
+
+        bool start(const char* path, float frameDt, int positionBits = TRAJECTORY_POSITION_BITS);
+        void stop();
+        bool isRecording() const { return worker.joinable(); }
+
+        // Producer thread only
+        void capture(const ParticleSystem& particles, uint64_t frame, uint64_t layoutVersion);
+
+        // Same, but fill(ParticleSystem&) writes the free slot itself, so state
+        // kept in another form (compact storage) is widened once, into the slot
+        template <typename Fill>
+        void capture(uint64_t frame, uint64_t layoutVersion, Fill&& fill) {
+            int slot;
+            if (!acquireSlot(slot)) return;
+            fill(slots[slot].particles);
+            commitSlot(slot, frame, layoutVersion);
+        }
+
+        uint64_t droppedFrames() const { return dropped.load(std::memory_order_relaxed); }
+
+    private:
+        struct CapturedFrame {
+            ParticleSystem particles;
+            uint64_t frame = 0;
+            uint64_t layoutVersion = 0;
+        };
+
+        bool acquireSlot(int& slot);
+        void commitSlot(int slot, uint64_t frame, uint64_t layoutVersion);
+        void run();
+        void encode(const CapturedFrame& captured);
+
+        CapturedFrame slots[FRAME_SLOTS];
+        SpscQueue<int, FRAME_SLOTS> freeSlots;   // Worker -> producer
+        SpscQueue<int, FRAME_SLOTS> readySlots;  // Producer -> worker
+
+        TrajectoryWriter writer;
+        std::string outputPath;
+        std::thread worker;
+        std::atomic<bool> running{false};
+        std::atomic<uint64_t> dropped{0};
+};
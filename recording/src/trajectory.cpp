@@ -0,0 +1,369 @@
+#include "trajectory.hpp"
+#include "common.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+namespace {
+    const char MAGIC[8] = { 'P', 'S', 'I', 'M', 'T', 'R', 'A', 'J' };
+    constexpr uint32_t CHUNK_MAGIC = 0x4B4E4843; // "CHNK"
+    uint16_t quantize(float v, float extent, float quantMax) {
+        float q = v * (quantMax / extent) + 0.5f;
+        return static_cast<uint16_t>(std::min(quantMax, std::max(0.0f, q)));
+    }
+
+    uint32_t zigzag(int32_t v) { return (static_cast<uint32_t>(v) << 1) ^ static_cast<uint32_t>(v >> 31); }
+    int32_t unzigzag(uint32_t v) { return static_cast<int32_t>(v >> 1) ^ -static_cast<int32_t>(v & 1); }
+
+    // Linear extrapolation from the two previous frames once both exist
+    int32_t predict(int order, const std::vector<uint16_t>* prev, int i, int32_t spatial) {
+        if (order == 0) return spatial;
+        if (order == 1) return prev[0][i];
+        int32_t p = 2 * static_cast<int32_t>(prev[0][i]) - static_cast<int32_t>(prev[1][i]);
+        return std::min(65535, std::max(0, p));
+    }
+
+    // Each block: one width byte, then `width` bits per value, LSB first
+    void packStream(const uint32_t* values, int n, std::vector<uint8_t>& out) {
+        for (int b = 0; b < n; b += TRAJECTORY_BLOCK_SIZE) {
+            int m = std::min(TRAJECTORY_BLOCK_SIZE, n - b);
+            uint32_t all = 0;
+            for (int i = 0; i < m; ++i) all |= values[b + i];
+            int width = all ? 32 - __builtin_clz(all) : 0;
+            out.push_back(static_cast<uint8_t>(width));
+            if (width == 0) continue;
+
+            size_t start = out.size();
+            out.resize(start + (static_cast<size_t>(m) * width + 7) / 8);
+            uint8_t* dst = out.data() + start;
+            uint64_t acc = 0;
+            int bits = 0;
+            for (int i = 0; i < m; ++i) {
+                acc |= static_cast<uint64_t>(values[b + i]) << bits;
+                bits += width;
+                while (bits >= 8) {
+                    *dst++ = static_cast<uint8_t>(acc);
+                    acc >>= 8;
+                    bits -= 8;
+                }
+            }
+            if (bits > 0) *dst = static_cast<uint8_t>(acc);
+        }
+    }
+
+    // Returns the first byte after the stream, or nullptr if it overruns end
+    const uint8_t* unpackStream(const uint8_t* in, const uint8_t* end, uint32_t* values, int n) {
+        for (int b = 0; b < n; b += TRAJECTORY_BLOCK_SIZE) {
+            int m = std::min(TRAJECTORY_BLOCK_SIZE, n - b);
+            if (in >= end) return nullptr;
+            int width = *in++;
+            if (width > 32) return nullptr;
+            if (width == 0) {
+                std::fill(values + b, values + b + m, 0u);
+                continue;
+            }
+            if (static_cast<size_t>(end - in) < (static_cast<size_t>(m) * width + 7) / 8) return nullptr;
+
+            uint64_t mask = (1ULL << width) - 1;
+            uint64_t acc = 0;
+            int bits = 0;
+            for (int i = 0; i < m; ++i) {
+                while (bits < width) {
+                    acc |= static_cast<uint64_t>(*in++) << bits;
+                    bits += 8;
+                }
+                values[b + i] = static_cast<uint32_t>(acc & mask);
+                acc >>= width;
+                bits -= width;
+            }
+        }
+        return in;
+    }
+
+    template <typename T>
+    void append(std::vector<uint8_t>& out, const T& value) {
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+        out.insert(out.end(), bytes, bytes + sizeof(T));
+    }
+}
+
+// --- Writer ---
+
+TrajectoryWriter::~TrajectoryWriter() {
+    close();
+}
+
+bool TrajectoryWriter::open(const char* path, float frameDt, int positionBits) {
+    close();
+    if (positionBits < 1 || positionBits > 16) {
+        std::cerr << "[Trajectory] Position precision must be 1-16 bits" << std::endl;
+        return false;
+    }
+
+    file = std::fopen(path, "wb");
+    if (!file) {
+        std::cerr << "[Trajectory] Cannot create " << path << std::endl;
+        return false;
+    }
+
+    TrajectoryHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = TRAJECTORY_VERSION;
+    header.headerSize = sizeof(TrajectoryHeader);
+    header.domainWidth = SIM_WIDTH;
+    header.domainHeight = SIM_HEIGHT;
+    header.frameDt = frameDt;
+    header.maxSpeedSq = TRAJECTORY_MAX_SPEED_SQ;
+    header.colorLevels = TRAJECTORY_COLOR_LEVELS;
+    header.positionBits = static_cast<uint32_t>(positionBits);
+
+    quantMax = static_cast<float>((1 << positionBits) - 1);
+    totalBytes = 0;
+    totalFrames = 0;
+    chunk = {};
+    chunkPayload.clear();
+
+    if (std::fwrite(&header, sizeof(header), 1, file) != 1) {
+        close();
+        return false;
+    }
+    totalBytes = sizeof(header);
+    return true;
+}
+
+bool TrajectoryWriter::write(const TrajectoryFrameView& view) {
+    if (!file) return false;
+    int n = view.count;
+
+    // 1. Chunks never span a count or layout change, and stay bounded in size
+    if (chunk.frameCount > 0 && (static_cast<uint32_t>(n) != chunk.particleCount || view.layoutVersion != chunkLayout)) {
+        if (!flushChunk()) return false;
+    }
+    if (chunk.frameCount == 0) {
+        chunk.particleCount = static_cast<uint32_t>(n);
+        chunk.firstFrame = view.frame;
+        chunkLayout = view.layoutVersion;
+    }
+
+    // 2. Quantize
+    qx.resize(n);
+    qy.resize(n);
+    qc.resize(n);
+    const float colorScale = (TRAJECTORY_COLOR_LEVELS - 1) / TRAJECTORY_MAX_SPEED_SQ;
+    for (int i = 0; i < n; ++i) {
+        qx[i] = quantize(view.posX[i], SIM_WIDTH, quantMax);
+        qy[i] = quantize(view.posY[i], SIM_HEIGHT, quantMax);
+        float vSq = view.velX[i] * view.velX[i] + view.velY[i] * view.velY[i];
+        qc[i] = static_cast<uint8_t>(std::min(TRAJECTORY_COLOR_LEVELS - 1, static_cast<int>(vSq * colorScale)));
+    }
+
+    // 3. Frame header (patched below), planets
+    size_t frameStart = chunkPayload.size();
+    const PlanetSystem& planets = *view.planets;
+    TrajectoryFrameHeader frameHeader = { view.frame, static_cast<uint32_t>(planets.size()), 0 };
+    append(chunkPayload, frameHeader);
+    for (size_t p = 0; p < planets.size(); ++p) {
+        append(chunkPayload, TrajectoryPlanet{ planets.x[p], planets.y[p], planets.radius[p], planets.color[p] });
+    }
+
+    // 4. Residual streams
+    int order = static_cast<int>(std::min<uint32_t>(chunk.frameCount, 2));
+    residuals.resize(n);
+    for (int axis = 0; axis < 2; ++axis) {
+        const std::vector<uint16_t>& q = axis == 0 ? qx : qy;
+        const std::vector<uint16_t>* prev = axis == 0 ? prevX : prevY;
+        for (int i = 0; i < n; ++i) {
+            int32_t spatial = i > 0 ? q[i - 1] : 0;
+            residuals[i] = zigzag(static_cast<int32_t>(q[i]) - predict(order, prev, i, spatial));
+        }
+        packStream(residuals.data(), n, chunkPayload);
+    }
+    for (int i = 0; i < n; ++i) {
+        int32_t pred = order == 0 ? (i > 0 ? qc[i - 1] : 0) : prevColor[i];
+        residuals[i] = zigzag(static_cast<int32_t>(qc[i]) - pred);
+    }
+    packStream(residuals.data(), n, chunkPayload);
+
+    TrajectoryFrameHeader* written = reinterpret_cast<TrajectoryFrameHeader*>(chunkPayload.data() + frameStart);
+    written->payloadBytes = static_cast<uint32_t>(chunkPayload.size() - frameStart - sizeof(TrajectoryFrameHeader));
+
+    // 5. Shift history: the current frame becomes prev[0]
+    prevX[1].swap(prevX[0]);
+    prevX[0].swap(qx);
+    prevY[1].swap(prevY[0]);
+    prevY[0].swap(qy);
+    prevColor.swap(qc);
+
+    chunk.frameCount++;
+    chunk.lastFrame = view.frame;
+    totalFrames++;
+
+    if (chunk.frameCount == TRAJECTORY_CHUNK_FRAMES) return flushChunk();
+    return true;
+}
+
+bool TrajectoryWriter::flushChunk() {
+    if (chunk.frameCount == 0) return true;
+
+    chunk.magic = CHUNK_MAGIC;
+    chunk.payloadBytes = static_cast<uint32_t>(chunkPayload.size());
+    bool ok = std::fwrite(&chunk, sizeof(chunk), 1, file) == 1 &&
+              std::fwrite(chunkPayload.data(), 1, chunkPayload.size(), file) == chunkPayload.size();
+    totalBytes += sizeof(chunk) + chunkPayload.size();
+
+    chunk = {};
+    chunkPayload.clear();
+    if (!ok) std::cerr << "[Trajectory] Write failed" << std::endl;
+    return ok;
+}
+
+bool TrajectoryWriter::close() {
+    if (!file) return true;
+    bool ok = flushChunk();
+    if (std::fclose(file) != 0) ok = false;
+    file = nullptr;
+    return ok;
+}
+
+// --- Reader ---
+
+TrajectoryReader::~TrajectoryReader() {
+    close();
+}
+
+bool TrajectoryReader::open(const char* path) {
+    close();
+    file = std::fopen(path, "rb");
+    if (!file) {
+        std::cerr << "[Trajectory] Cannot open " << path << std::endl;
+        return false;
+    }
+
+    if (std::fread(&fileHeader, sizeof(fileHeader), 1, file) != 1 ||
+        std::memcmp(fileHeader.magic, MAGIC, sizeof(MAGIC)) != 0 ||
+        fileHeader.version != TRAJECTORY_VERSION ||
+        fileHeader.headerSize != sizeof(TrajectoryHeader) ||
+        fileHeader.colorLevels != TRAJECTORY_COLOR_LEVELS ||
+        fileHeader.positionBits < 1 || fileHeader.positionBits > 16) {
+        std::cerr << "[Trajectory] " << path << " is not a supported trajectory file" << std::endl;
+        close();
+        return false;
+    }
+
+    std::fseek(file, 0, SEEK_END);
+    long fileSize = std::ftell(file);
+    long offset = sizeof(TrajectoryHeader);
+
+    // Index complete chunks; a recording cut short just ends early
+    TrajectoryChunkHeader h;
+    while (std::fseek(file, offset, SEEK_SET) == 0 && std::fread(&h, sizeof(h), 1, file) == 1) {
+        long next = offset + static_cast<long>(sizeof(h)) + static_cast<long>(h.payloadBytes);
+        if (h.magic != CHUNK_MAGIC || h.frameCount == 0 || next > fileSize) break;
+        if (chunkOffsets.empty()) frameRange[0] = h.firstFrame;
+        frameRange[1] = h.lastFrame;
+        chunkOffsets.push_back(offset);
+        offset = next;
+    }
+
+    if (chunkOffsets.empty()) {
+        std::cerr << "[Trajectory] " << path << " holds no complete chunk" << std::endl;
+        close();
+        return false;
+    }
+    return true;
+}
+
+void TrajectoryReader::close() {
+    if (file) std::fclose(file);
+    file = nullptr;
+    chunkOffsets.clear();
+    chunk = {};
+    decodedFrames = 0;
+}
+
+bool TrajectoryReader::loadChunk(int index) {
+    if (!file || index < 0 || index >= chunkCount()) return false;
+    if (std::fseek(file, chunkOffsets[index], SEEK_SET) != 0 ||
+        std::fread(&chunk, sizeof(chunk), 1, file) != 1) return false;
+
+    chunkPayload.resize(chunk.payloadBytes);
+    if (std::fread(chunkPayload.data(), 1, chunkPayload.size(), file) != chunkPayload.size()) return false;
+
+    cursor = 0;
+    decodedFrames = 0;
+    return true;
+}
+
+bool TrajectoryReader::decodeNext(ParticleSystem& out, uint64_t& frame) {
+    if (decodedFrames >= chunk.frameCount) return false;
+
+    const uint8_t* begin = chunkPayload.data() + cursor;
+    const uint8_t* end = chunkPayload.data() + chunkPayload.size();
+    TrajectoryFrameHeader frameHeader;
+    if (static_cast<size_t>(end - begin) < sizeof(frameHeader)) return false;
+    std::memcpy(&frameHeader, begin, sizeof(frameHeader));
+    const uint8_t* in = begin + sizeof(frameHeader);
+    if (static_cast<size_t>(end - in) < frameHeader.payloadBytes) return false;
+    end = in + frameHeader.payloadBytes;
+
+    // 1. Planets
+    if (static_cast<size_t>(end - in) < static_cast<size_t>(frameHeader.planetCount) * sizeof(TrajectoryPlanet)) return false;
+    out.planets.resize(frameHeader.planetCount);
+    for (uint32_t p = 0; p < frameHeader.planetCount; ++p) {
+        TrajectoryPlanet record;
+        std::memcpy(&record, in, sizeof(record));
+        in += sizeof(record);
+        out.planets.set(p, Planet{ record.x, record.y, 0.0f, 0.0f, 0.0f, record.radius, record.color });
+    }
+
+    // 2. Positions
+    int n = static_cast<int>(chunk.particleCount);
+    int order = static_cast<int>(std::min<uint32_t>(decodedFrames, 2));
+    residuals.resize(n);
+    for (int axis = 0; axis < 2; ++axis) {
+        std::vector<uint16_t>* prev = axis == 0 ? prevX : prevY;
+        in = unpackStream(in, end, residuals.data(), n);
+        if (!in) return false;
+
+        // Decode into prev[1]'s storage: it is the history slot that drops out
+        std::vector<uint16_t>& q = prev[1];
+        q.resize(n);
+        for (int i = 0; i < n; ++i) {
+            int32_t spatial = i > 0 ? q[i - 1] : 0;
+            q[i] = static_cast<uint16_t>(predict(order, prev, i, spatial) + unzigzag(residuals[i]));
+        }
+        prev[0].swap(prev[1]);
+    }
+
+    // 3. Colors
+    in = unpackStream(in, end, residuals.data(), n);
+    if (!in) return false;
+    prevColor.resize(n);
+    for (int i = 0; i < n; ++i) {
+        int32_t pred = order == 0 ? (i > 0 ? prevColor[i - 1] : 0) : prevColor[i];
+        prevColor[i] = static_cast<uint8_t>(pred + unzigzag(residuals[i]));
+    }
+
+    // 4. Rebuild a ParticleSystem the renderers understand: a velocity whose
+    //    speed maps back onto the recorded color level
+    float quantMax = static_cast<float>((1u << fileHeader.positionBits) - 1);
+    float scaleX = fileHeader.domainWidth / quantMax;
+    float scaleY = fileHeader.domainHeight / quantMax;
+    float levelToSpeedSq = fileHeader.maxSpeedSq / (TRAJECTORY_COLOR_LEVELS - 1);
+    out.posX.resize(n);
+    out.posY.resize(n);
+    out.velX.resize(n);
+    out.velY.assign(n, 0.0f);
+    for (int i = 0; i < n; ++i) {
+        out.posX[i] = prevX[0][i] * scaleX;
+        out.posY[i] = prevY[0][i] * scaleY;
+        out.velX[i] = std::sqrt((prevColor[i] + 0.5f) * levelToSpeedSq);
+    }
+
+    cursor = static_cast<size_t>(end - chunkPayload.data());
+    decodedFrames++;
+    frame = frameHeader.frame;
+    return true;
+}
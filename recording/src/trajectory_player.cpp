@@ -0,0 +1,112 @@
+#include "trajectory_player.hpp"
+#include <chrono>
+#include <iostream>
+
+TrajectoryPlayer::~TrajectoryPlayer() {
+    close();
+}
+
+bool TrajectoryPlayer::open(const char* path, bool loop) {
+    close();
+    if (!reader.open(path)) return false;
+
+    frameDt = reader.header().frameDt > 0.0f ? reader.header().frameDt : 0.016f;
+    looping = loop;
+
+    int slot;
+    while (readySlots.pop(slot)) {}
+    while (freeSlots.pop(slot)) {}
+    for (int i = 0; i < FRAME_SLOTS; ++i) freeSlots.push(i);
+    currentSlot = -1;
+    pendingSlot = -1;
+    currentPass = 0;
+    clock = static_cast<double>(reader.firstFrame());
+
+    exhausted.store(false);
+    running.store(true);
+    worker = std::thread(&TrajectoryPlayer::run, this);
+
+    std::cout << "[TrajectoryPlayer] " << path << ": " << reader.chunkCount() << " chunks, frames "
+              << reader.firstFrame() << "-" << reader.lastFrame() << std::endl;
+    return true;
+}
+
+void TrajectoryPlayer::close() {
+    running.store(false);
+    if (worker.joinable()) worker.join();
+    reader.close();
+    currentSlot = -1;
+    pendingSlot = -1;
+}
+
+void TrajectoryPlayer::run() {
+    int chunk = 0;
+    uint32_t pass = 0;
+    int slot = -1; // Free slot held across chunk boundaries
+
+    while (running.load(std::memory_order_relaxed)) {
+        // 1. Next chunk, wrapping around when looping
+        if (chunk == reader.chunkCount()) {
+            if (!looping) break;
+            chunk = 0;
+            pass++;
+        }
+        if (!reader.loadChunk(chunk++)) {
+            std::cerr << "[TrajectoryPlayer] Failed to read chunk " << chunk - 1 << std::endl;
+            break;
+        }
+
+        // 2. Decode its frames as slots free up
+        while (running.load(std::memory_order_relaxed)) {
+            if (slot < 0 && !freeSlots.pop(slot)) {
+                slot = -1;
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                continue;
+            }
+            DecodedFrame& decoded = slots[slot];
+            if (!reader.decodeNext(decoded.particles, decoded.frame)) break;
+            decoded.pass = pass;
+            readySlots.push(slot);
+            slot = -1;
+        }
+    }
+    exhausted.store(true);
+}
+
+bool TrajectoryPlayer::takeReady() {
+    if (pendingSlot >= 0) return true;
+    int slot;
+    if (!readySlots.pop(slot)) return false;
+    pendingSlot = slot;
+    return true;
+}
+
+bool TrajectoryPlayer::advance(double seconds, float speed) {
+    // speed 0 mirrors the simulation's "unthrottled": one new frame per call
+    if (speed > 0.0f) {
+        clock += seconds * speed / frameDt;
+    } else if (takeReady()) {
+        clock = static_cast<double>(slots[pendingSlot].frame);
+    }
+
+    bool changed = false;
+    while (takeReady()) {
+        const DecodedFrame& next = slots[pendingSlot];
+        if (next.pass != currentPass) {
+            // Wrapped around: restart the clock at the first frame
+            currentPass = next.pass;
+            clock = static_cast<double>(next.frame);
+        }
+        if (currentSlot >= 0 && static_cast<double>(next.frame) > clock) break;
+
+        if (currentSlot >= 0) freeSlots.push(currentSlot);
+        currentSlot = pendingSlot;
+        pendingSlot = -1;
+        changed = true;
+    }
+    return changed;
+}
+
+bool TrajectoryPlayer::finished() {
+    return exhausted.load() && !takeReady();
+}
@@ -0,0 +1,85 @@
+#include "trajectory_recorder.hpp"
+#include <chrono>
+#include <iostream>
+
+TrajectoryRecorder::~TrajectoryRecorder() {
+    stop();
+}
+
+bool TrajectoryRecorder::start(const char* path, float frameDt, int positionBits) {
+    if (isRecording()) stop();
+    if (!writer.open(path, frameDt, positionBits)) return false;
+
+    // All slots start out free
+    int slot;
+    while (readySlots.pop(slot)) {}
+    while (freeSlots.pop(slot)) {}
+    for (int i = 0; i < FRAME_SLOTS; ++i) freeSlots.push(i);
+
+    outputPath = path;
+    dropped.store(0, std::memory_order_relaxed);
+    running.store(true);
+    worker = std::thread(&TrajectoryRecorder::run, this);
+    std::cout << "[TrajectoryRecorder] Recording to " << outputPath << std::endl;
+    return true;
+}
+
+void TrajectoryRecorder::stop() {
+    if (!worker.joinable()) return;
+    running.store(false);
+    worker.join();
+
+    uint64_t frames = writer.framesWritten();
+    uint64_t bytes = writer.bytesWritten();
+    writer.close();
+    std::cout << "[TrajectoryRecorder] Wrote " << frames << " frames, " << bytes / (1024.0 * 1024.0)
+              << " MiB to " << outputPath << " (" << droppedFrames() << " dropped)" << std::endl;
+}
+
+void TrajectoryRecorder::capture(const ParticleSystem& particles, uint64_t frame, uint64_t layoutVersion) {
+    // Vector assignment reuses the slot's capacity: no allocation in steady state
+    capture(frame, layoutVersion, [&](ParticleSystem& captured) {
+        captured.posX = particles.posX;
+        captured.posY = particles.posY;
+        captured.velX = particles.velX;
+        captured.velY = particles.velY;
+        captured.planets = particles.planets;
+    });
+}
+
+bool TrajectoryRecorder::acquireSlot(int& slot) {
+    if (freeSlots.pop(slot)) return true;
+    dropped.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+void TrajectoryRecorder::commitSlot(int slot, uint64_t frame, uint64_t layoutVersion) {
+    slots[slot].frame = frame;
+    slots[slot].layoutVersion = layoutVersion;
+    readySlots.push(slot);
+}
+
+void TrajectoryRecorder::encode(const CapturedFrame& captured) {
+    const ParticleSystem& p = captured.particles;
+    TrajectoryFrameView view = {
+        p.posX.data(), p.posY.data(), p.velX.data(), p.velY.data(), static_cast<int>(p.posX.size()),
+        &p.planets,
+        captured.frame, captured.layoutVersion
+    };
+    writer.write(view);
+}
+
+void TrajectoryRecorder::run() {
+    while (true) {
+        // Read the flag first: once stop() is seen, every capture is already queued
+        bool stopping = !running.load();
+        int slot;
+        if (readySlots.pop(slot)) {
+            encode(slots[slot]);
+            freeSlots.push(slot);
+            continue;
+        }
+        if (stopping) break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
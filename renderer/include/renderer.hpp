@@ -3,7 +3,9 @@
 #include <SDL2/SDL.h>
 #include <vector>
 #include <cstdint>
+#include <string>
 #include "common.hpp"
+#include "rasterizer.hpp"
 
 // Forward declaration for ImGui
 struct SDL_Window;
@@ -18,9 +20,23 @@ class Renderer {
         void shutdown();
         
         bool handleEvents(SimConfig& config);
-        void render(const std::vector<uint32_t>& buffer, SimConfig& config);
+
+        // Draw into the streaming texture's own memory between
+        // lockFrame() and unlockFrame(), then call present()
+        uint32_t* lockFrame(int& pitch);
+        void unlockFrame();
+        void present(SimConfig& config);
+
+        // Part of the simulation box the camera shows (wheel zooms at the
+        // cursor, right or middle drag pans, Home resets)
+        Viewport viewport() const;
 
     private:
+        void buildInterface(SimConfig& config);
+        void screenToWorld(int screenX, int screenY, float& worldX, float& worldY) const;
+        void clampCamera();
+        void drawProfilerPanel();
+
         SDL_Window* window = nullptr;
         SDL_Renderer* renderer = nullptr;
         SDL_Texture* texture = nullptr;
@@ -29,6 +45,18 @@ class Renderer {
         int renderWidth = 0;
         int renderHeight = 0;
         
+        // --- Camera ---
+        static constexpr float MAX_ZOOM = 1000.0f;
+        static constexpr float ZOOM_STEP = 1.25f;      // Per wheel notch
+        float cameraX = SIM_WIDTH / 2.0f;              // View center, simulation units
+        float cameraY = SIM_HEIGHT / 2.0f;
+        float zoom = 1.0f;                             // 1 = whole box
+        bool panning = false;
+        int panX = 0;
+        int panY = 0;
+
         // UI State
         bool showUI = true;
+        int traceDumpCount = 0;
+        std::string traceStatus;
 };
\ No newline at end of file
@@ -1,4 +1,7 @@
 #include "renderer.hpp"
+#include "profiler.hpp"
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 
 #include "imgui.h"
@@ -64,20 +67,54 @@ bool Renderer::handleEvents(SimConfig& config) {
             config.paused = !config.paused;
         }
         
-        // --- 2. Handle Spawning (If ImGui is not using the mouse) ---
+        // --- 2. Reset the camera on Home ---
+        if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_HOME && !ImGui::GetIO().WantCaptureKeyboard) {
+            zoom = 1.0f;
+            clampCamera();
+        }
+
+        // --- 3. Camera and spawning (if ImGui is not using the mouse) ---
+        if (event.type == SDL_MOUSEBUTTONUP &&
+            (event.button.button == SDL_BUTTON_RIGHT || event.button.button == SDL_BUTTON_MIDDLE)) {
+            panning = false;
+        }
+        if (event.type == SDL_MOUSEMOTION && panning) {
+            // Drag the scene with the cursor
+            Viewport view = viewport();
+            cameraX -= (event.motion.x - panX) * view.width / renderWidth;
+            cameraY -= (event.motion.y - panY) * view.height / renderHeight;
+            panX = event.motion.x;
+            panY = event.motion.y;
+            clampCamera();
+        }
+
         if (!ImGui::GetIO().WantCaptureMouse) {
+            if (event.type == SDL_MOUSEWHEEL && event.wheel.y != 0) {
+                // Zoom about the cursor: the point under it stays put
+                int mouseX, mouseY;
+                SDL_GetMouseState(&mouseX, &mouseY);
+                float anchorX, anchorY;
+                screenToWorld(mouseX, mouseY, anchorX, anchorY);
+
+                float oldZoom = zoom;
+                zoom = std::min(MAX_ZOOM, std::max(1.0f, zoom * std::pow(ZOOM_STEP, static_cast<float>(event.wheel.y))));
+                cameraX = anchorX + (cameraX - anchorX) * oldZoom / zoom;
+                cameraY = anchorY + (cameraY - anchorY) * oldZoom / zoom;
+                clampCamera();
+            }
+
+            if (event.type == SDL_MOUSEBUTTONDOWN &&
+                (event.button.button == SDL_BUTTON_RIGHT || event.button.button == SDL_BUTTON_MIDDLE)) {
+                panning = true;
+                panX = event.button.x;
+                panY = event.button.y;
+            }
+
             if (event.type == SDL_MOUSEBUTTONDOWN && event.button.button == SDL_BUTTON_LEFT) {
-                // Convert Screen Coords -> Simulation Coords
+                // Convert Screen Coords -> Simulation Coords through the camera
                 int logicalX, logicalY;
                 SDL_GetMouseState(&logicalX, &logicalY);
-                
-                // Adjust for scale
-                // logicalX is 0..1024, SIM_WIDTH is 0..300
-                float scaleX = SIM_WIDTH / static_cast<float>(renderWidth);
-                float scaleY = SIM_HEIGHT / static_cast<float>(renderHeight);
-                
-                config.spawnX = logicalX * scaleX;
-                config.spawnY = logicalY * scaleY;
+                screenToWorld(logicalX, logicalY, config.spawnX, config.spawnY);
                 config.spawnClick = true; // Signal kinematics to spawn next frame
             }
         }
@@ -85,9 +122,55 @@ bool Renderer::handleEvents(SimConfig& config) {
     return true;
 }
 
-void Renderer::render(const std::vector<uint32_t>& buffer, SimConfig& config) {
-    SDL_UpdateTexture(texture, nullptr, buffer.data(), renderWidth * sizeof(uint32_t));
-    
+Viewport Renderer::viewport() const {
+    Viewport view;
+    view.width = SIM_WIDTH / zoom;
+    view.height = SIM_HEIGHT / zoom;
+    view.x = cameraX - view.width / 2.0f;
+    view.y = cameraY - view.height / 2.0f;
+    return view;
+}
+
+void Renderer::screenToWorld(int screenX, int screenY, float& worldX, float& worldY) const {
+    // screenX is 0..renderWidth, the view spans view.width simulation units
+    Viewport view = viewport();
+    worldX = view.x + screenX * view.width / static_cast<float>(renderWidth);
+    worldY = view.y + screenY * view.height / static_cast<float>(renderHeight);
+}
+
+void Renderer::clampCamera() {
+    // Keep the view inside the box
+    float halfW = SIM_WIDTH / (2.0f * zoom), halfH = SIM_HEIGHT / (2.0f * zoom);
+    cameraX = std::min(std::max(cameraX, halfW), SIM_WIDTH - halfW);
+    cameraY = std::min(std::max(cameraY, halfH), SIM_HEIGHT - halfH);
+}
+
+uint32_t* Renderer::lockFrame(int& pitch) {
+    void* pixels = nullptr;
+    if (SDL_LockTexture(texture, nullptr, &pixels, &pitch) != 0) {
+        std::cerr << "[Renderer] SDL_LockTexture failed: " << SDL_GetError() << std::endl;
+        return nullptr;
+    }
+    return static_cast<uint32_t*>(pixels);
+}
+
+void Renderer::unlockFrame() {
+    SDL_UnlockTexture(texture);
+}
+
+void Renderer::present(SimConfig& config) {
+    {
+        ProfileScope scope(ProfilePhase::Interface);
+        buildInterface(config);
+    }
+
+    ProfileScope scope(ProfilePhase::Present);
+    SDL_RenderCopy(renderer, texture, nullptr, nullptr);
+    ImGui_ImplSDLRenderer2_RenderDrawData(ImGui::GetDrawData(), renderer);
+    SDL_RenderPresent(renderer);
+}
+
+void Renderer::buildInterface(SimConfig& config) {
     ImGui_ImplSDLRenderer2_NewFrame();
     ImGui_ImplSDL2_NewFrame();
     ImGui::NewFrame();
@@ -96,6 +179,7 @@ void Renderer::render(const std::vector<uint32_t>& buffer, SimConfig& config) {
         ImGui::Begin("Cosmic Controls");
         
         ImGui::Text("FPS: %.1f", ImGui::GetIO().Framerate);
+        ImGui::Text("Zoom %.1fx (wheel; right-drag pans, Home resets)", zoom);
         
         // --- Pause Control ---
         ImGui::Separator();
@@ -132,12 +216,64 @@ void Renderer::render(const std::vector<uint32_t>& buffer, SimConfig& config) {
         ImGui::Text("System Config");
         ImGui::SliderInt("Particles", &config.particleCount, 100, 10000);
         ImGui::SliderFloat("Star Mass", &config.starMass, 100.0f, 20000.0f);
+        ImGui::SliderFloat("Sim Speed (0 = max)", &config.simSpeed, 0.0f, 8.0f);
+        ImGui::Checkbox("Accretion", &config.enableAccretion);
+
+        ImGui::Checkbox("Inter-Particle Gravity", &config.enableInterParticleGravity);
+        if (config.enableInterParticleGravity) {
+            ImGui::SliderFloat("G", &config.interParticleG, 0.0f, 1.0f);
+            ImGui::SliderFloat("Opening Angle", &config.barnesHutTheta, 0.1f, 1.5f);
+        }
+
+        // --- Trajectory Recording ---
+        ImGui::Separator();
+        ImGui::InputText("Trajectory", config.trajectoryPath, sizeof(config.trajectoryPath));
+        ImGui::Checkbox("Record Trajectory", &config.recordTrajectory);
+
+        // --- Checkpoint ---
+        ImGui::Separator();
+        ImGui::InputText("File", config.checkpointPath, sizeof(config.checkpointPath));
+        if (ImGui::Button("Save Checkpoint")) config.saveCheckpoint = true;
+        ImGui::SameLine();
+        if (ImGui::Button("Load Checkpoint")) config.loadCheckpoint = true;
+
+        drawProfilerPanel();
         
         ImGui::End();
     }
 
     ImGui::Render();
-    SDL_RenderCopy(renderer, texture, nullptr, nullptr);
-    ImGui_ImplSDLRenderer2_RenderDrawData(ImGui::GetDrawData(), renderer);
-    SDL_RenderPresent(renderer);
+}
+
+void Renderer::drawProfilerPanel() {
+    ImGui::Separator();
+    if (!ImGui::CollapsingHeader("Profiler")) return;
+
+    Profiler& profiler = Profiler::instance();
+    bool enabled = profiler.isEnabled();
+    if (ImGui::Checkbox("Record Timings", &enabled)) profiler.setEnabled(enabled);
+
+    float history[Profiler::HISTORY_SIZE];
+    for (int i = 0; i < static_cast<int>(ProfilePhase::Count); ++i) {
+        ProfilePhase phase = static_cast<ProfilePhase>(i);
+        ProfileStats st = profiler.stats(phase);
+        if (st.samples == 0) continue;
+
+        ImGui::Text("%-11s min %6.2f  avg %6.2f  p99 %6.2f ms",
+                    profilePhaseName(phase), st.minMs, st.avgMs, st.p99Ms);
+        int count = profiler.history(phase, history, Profiler::HISTORY_SIZE);
+        ImGui::PushID(i);
+        ImGui::PlotLines("##history", history, count, 0, nullptr, 0.0f, st.p99Ms * 1.2f, ImVec2(0, 32));
+        ImGui::PopID();
+    }
+
+    if (ImGui::Button("Dump Chrome Trace")) {
+        std::string path = "particle_trace_" + std::to_string(traceDumpCount++) + ".json";
+        traceStatus = profiler.dumpChromeTrace(path) ? "Wrote " + path : "Failed to write " + path;
+        std::cout << "[Profiler] " << traceStatus << std::endl;
+    }
+    if (!traceStatus.empty()) {
+        ImGui::SameLine();
+        ImGui::TextDisabled("%s", traceStatus.c_str());
+    }
 }
\ No newline at end of file
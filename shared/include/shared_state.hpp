@@ -0,0 +1,185 @@
+#pragma once
+
+#include "particle.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Live simulation state in POSIX shared memory (/dev/shm/<name>), so local
+// processes can map it and read the arrays in place.
+//
+// Layout (little-endian, every section starts on a 64-byte boundary):
+//   SharedStateHeader (one page) | slot 0 | slot 1
+//   slot = SharedSlotHeader | posX | posY | velX | velY | planet arrays
+//
+// Arrays are sized for particleCapacity / planetCapacity; the slot header
+// says how many entries are valid. arrayOffset gives each array's position
+// from the start of its slot.
+//
+// Frames are only written when a reader asks: readers bump `requested`, the
+// simulation sees it at the end of a step and copies the state into the slot
+// that does not hold the newest frame, so a reader has a whole publish
+// interval to finish with a frame. Each slot is a seqlock:
+//
+//   n = published (acquire); if n == 0 nothing yet
+//   slot = (n - 1) % SHARED_STATE_SLOTS
+//   s1 = slot.sequence (acquire); odd -> retry
+//   ... read the arrays in place ...
+//   s2 = slot.sequence; s1 != s2 -> torn, retry
+//
+// When the state outgrows the segment the writer creates a new one under the
+// same name and marks the old one Replaced; readers reopen by name. A writer
+// that exits marks it Closed.
+//
+// numpy (offsets as asserted below; a plain += on `requested` is enough, a
+// lost race with another reader still changes it):
+//   m = mmap.mmap(os.open("/dev/shm/particles", os.O_RDWR), 0)
+//   h = np.frombuffer(m, np.uint64, 18)       # h[16] published, h[17] requested
+//   h[17] += 1                                 # ask for a frame, wait for h[16] to move
+//   slot = int(h[2] + (h[16] - 1) % 2 * h[3]) # headerSize + i * slotBytes
+//   seq = np.frombuffer(m, np.uint64, 1, slot) # seq[0] before and after, as above
+//   count = int(np.frombuffer(m, np.uint32, 1, slot + 24)[0])
+//   posX = np.frombuffer(m, np.float32, count, slot + int(h[5]))
+
+constexpr uint32_t SHARED_STATE_VERSION = 1;
+constexpr int SHARED_STATE_SLOTS = 2;
+
+enum class SharedArray : int {
+    PosX = 0, PosY, VelX, VelY,
+    PlanetX, PlanetY, PlanetVX, PlanetVY, PlanetMass, PlanetRadius, PlanetColor,
+    Count
+};
+
+enum class SharedStatus : uint32_t { Live = 0, Replaced, Closed };
+
+struct SharedStateHeader {
+    char magic[8];              // "PSIMSHM"
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t headerSize;        // Slot 0 starts here
+    uint64_t slotBytes;         // Slot i starts at headerSize + i * slotBytes
+    uint32_t particleCapacity;
+    uint32_t planetCapacity;
+    uint64_t arrayOffset[static_cast<int>(SharedArray::Count)];
+
+    // --- Shared between processes ---
+    std::atomic<uint64_t> published;    // Frames completed; the newest is in slot (published - 1) % SLOTS
+    std::atomic<uint64_t> requested;    // Readers add one to ask for a new frame
+    std::atomic<uint32_t> status;       // SharedStatus
+};
+static_assert(offsetof(SharedStateHeader, published) == 128, "Header layout is part of the format");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "Counters must be address-free across processes");
+
+struct SharedSlotHeader {
+    std::atomic<uint64_t> sequence;     // Odd while the writer fills the slot
+    uint64_t frame;                     // Steps taken
+    uint64_t layoutVersion;             // Changes when asteroids are reordered, added or removed
+    uint32_t particleCount;
+    uint32_t planetCount;
+    uint8_t reserved[32];
+};
+static_assert(sizeof(SharedSlotHeader) == 64, "Slot header layout is part of the format");
+
+// Simulation side. wantsFrame() is a single relaxed load, so calling it every
+// step costs nothing while no reader is attached.
+class SharedStatePublisher {
+    public:
+        SharedStatePublisher() = default;
+        ~SharedStatePublisher();
+
+        SharedStatePublisher(const SharedStatePublisher&) = delete;
+        SharedStatePublisher& operator=(const SharedStatePublisher&) = delete;
+
+        // name as for shm_open ("/particles"); a missing leading '/' is added
+        bool open(const char* name);
+        void close();
+        bool isOpen() const { return header != nullptr; }
+
+        bool wantsFrame() const {
+            return header && header->requested.load(std::memory_order_relaxed) != served;
+        }
+        bool publish(const ParticleSystem& particles, uint64_t frame, uint64_t layoutVersion);
+
+        // Same, but fill(posX, posY, velX, velY) writes the `count` asteroids
+        // straight into the slot, so state kept in another form (compact
+        // storage) is widened once, into shared memory
+        template <typename Fill>
+        bool publish(const PlanetSystem& planets, size_t count, uint64_t frame, uint64_t layoutVersion, Fill&& fill) {
+            SharedSlotHeader* slot = beginFrame(planets, count, frame, layoutVersion);
+            if (!slot) return false;
+            fill(slotFloats(slot, SharedArray::PosX), slotFloats(slot, SharedArray::PosY),
+                 slotFloats(slot, SharedArray::VelX), slotFloats(slot, SharedArray::VelY));
+            endFrame(slot);
+            return true;
+        }
+
+        uint64_t framesPublished() const { return publishedTotal; }    // Across segment replacements
+
+    private:
+        bool create(uint32_t particleCapacity, uint32_t planetCapacity);
+        void release(SharedStatus status);
+
+        // Opens the seqlock of the slot readers are not directed to and writes
+        // everything but the asteroid arrays; endFrame() publishes it
+        SharedSlotHeader* beginFrame(const PlanetSystem& planets, size_t count, uint64_t frame, uint64_t layoutVersion);
+        void endFrame(SharedSlotHeader* slot);
+        float* slotFloats(SharedSlotHeader* slot, SharedArray which) const;
+
+        std::string name;
+        SharedStateHeader* header = nullptr;
+        size_t size = 0;
+        uint64_t served = 0;        // Value of `requested` when the last frame was started
+        uint64_t publishedTotal = 0;
+};
+
+// One frame read in place. Valid until the writer reuses the slot, which
+// SharedStateReader::validate() detects.
+struct SharedFrameView {
+    uint64_t frame = 0;
+    uint64_t layoutVersion = 0;
+    int particleCount = 0;
+    int planetCount = 0;
+    const float* posX = nullptr;
+    const float* posY = nullptr;
+    const float* velX = nullptr;
+    const float* velY = nullptr;
+    const float* planetX = nullptr;
+    const float* planetY = nullptr;
+    const float* planetMass = nullptr;
+    const float* planetRadius = nullptr;
+
+    const SharedSlotHeader* slot = nullptr;
+    uint64_t sequence = 0;
+};
+
+// Consumer side, for tools in this tree (see tools/shm_reader.cpp)
+class SharedStateReader {
+    public:
+        SharedStateReader() = default;
+        ~SharedStateReader();
+
+        SharedStateReader(const SharedStateReader&) = delete;
+        SharedStateReader& operator=(const SharedStateReader&) = delete;
+
+        bool open(const char* name, bool quiet = false);
+        void close();
+        bool isOpen() const { return header != nullptr; }
+
+        // Replaced: close() and reopen by name. Closed: the writer exited.
+        SharedStatus status() const {
+            return static_cast<SharedStatus>(header->status.load(std::memory_order_acquire));
+        }
+
+        void request();
+        uint64_t framesPublished() const { return header->published.load(std::memory_order_acquire); }
+
+        // Newest complete frame; false when none is published or the writer
+        // is mid-way through it. Check validate() after reading the arrays.
+        bool acquire(SharedFrameView& view) const;
+        bool validate(const SharedFrameView& view) const;
+
+    private:
+        SharedStateHeader* header = nullptr;
+        size_t size = 0;
+};
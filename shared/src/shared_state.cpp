@@ -0,0 +1,272 @@
+#include "shared_state.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <new>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "Shared state format assumes a little-endian host");
+
+namespace {
+    constexpr char SHARED_MAGIC[8] = { 'P', 'S', 'I', 'M', 'S', 'H', 'M', '\0' };
+    constexpr uint64_t SHARED_ALIGN = 64;
+    constexpr uint64_t SHARED_HEADER_BYTES = 4096;
+    constexpr uint32_t MIN_PARTICLE_CAPACITY = 4096;
+    constexpr uint32_t MIN_PLANET_CAPACITY = 64;
+
+    uint64_t alignUp(uint64_t value) {
+        return (value + SHARED_ALIGN - 1) & ~(SHARED_ALIGN - 1);
+    }
+
+    // Room to grow by a quarter before the segment has to be replaced
+    uint32_t capacityFor(size_t count, uint32_t minimum) {
+        return std::max<uint32_t>(minimum, static_cast<uint32_t>(count + count / 4));
+    }
+
+    SharedSlotHeader* slotAt(SharedStateHeader* header, uint64_t index) {
+        uint8_t* base = reinterpret_cast<uint8_t*>(header);
+        return reinterpret_cast<SharedSlotHeader*>(base + header->headerSize + (index % SHARED_STATE_SLOTS) * header->slotBytes);
+    }
+
+    template<typename T>
+    T* slotArray(const SharedStateHeader* header, const SharedSlotHeader* slot, SharedArray which) {
+        const uint8_t* base = reinterpret_cast<const uint8_t*>(slot);
+        return reinterpret_cast<T*>(const_cast<uint8_t*>(base + header->arrayOffset[static_cast<int>(which)]));
+    }
+
+    std::string segmentName(const char* name) {
+        return name[0] == '/' ? std::string(name) : "/" + std::string(name);
+    }
+}
+
+// --- Publisher ---
+
+SharedStatePublisher::~SharedStatePublisher() {
+    close();
+}
+
+bool SharedStatePublisher::open(const char* segment) {
+    close();
+    name = segmentName(segment);
+    publishedTotal = 0;
+    if (!create(MIN_PARTICLE_CAPACITY, MIN_PLANET_CAPACITY)) return false;
+    std::cout << "[SharedState] Publishing to /dev/shm" << name << " on request" << std::endl;
+    return true;
+}
+
+void SharedStatePublisher::close() {
+    if (!header) return;
+    release(SharedStatus::Closed);
+}
+
+bool SharedStatePublisher::create(uint32_t particleCapacity, uint32_t planetCapacity) {
+    // A segment left by a writer that crashed would make O_EXCL fail
+    shm_unlink(name.c_str());
+
+    int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0) {
+        std::cerr << "[SharedState] Cannot create " << name << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    // Slot layout: header, four asteroid arrays, then the planet arrays
+    uint64_t offsets[static_cast<int>(SharedArray::Count)];
+    uint64_t cursor = sizeof(SharedSlotHeader);
+    for (int a = 0; a < static_cast<int>(SharedArray::Count); ++a) {
+        offsets[a] = cursor;
+        uint32_t entries = a <= static_cast<int>(SharedArray::VelY) ? particleCapacity : planetCapacity;
+        cursor = alignUp(cursor + uint64_t(entries) * sizeof(float));
+    }
+    uint64_t slotBytes = cursor;
+    size_t length = SHARED_HEADER_BYTES + SHARED_STATE_SLOTS * slotBytes;
+
+    // Pages are only backed once written, so capacity that is never used costs no memory
+    void* mapped = MAP_FAILED;
+    if (ftruncate(fd, static_cast<off_t>(length)) == 0) {
+        mapped = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    int error = errno;
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        std::cerr << "[SharedState] Cannot map " << length << " bytes for " << name << ": " << std::strerror(error) << std::endl;
+        shm_unlink(name.c_str());
+        return false;
+    }
+
+    header = new (mapped) SharedStateHeader();
+    std::memcpy(header->magic, SHARED_MAGIC, sizeof(SHARED_MAGIC));
+    header->version = SHARED_STATE_VERSION;
+    header->headerSize = SHARED_HEADER_BYTES;
+    header->slotBytes = slotBytes;
+    header->particleCapacity = particleCapacity;
+    header->planetCapacity = planetCapacity;
+    std::memcpy(header->arrayOffset, offsets, sizeof(offsets));
+    header->published.store(0, std::memory_order_relaxed);
+    header->requested.store(0, std::memory_order_relaxed);
+    header->status.store(static_cast<uint32_t>(SharedStatus::Live), std::memory_order_release);
+    for (int s = 0; s < SHARED_STATE_SLOTS; ++s) new (slotAt(header, s)) SharedSlotHeader();
+
+    size = length;
+    served = 0;
+    return true;
+}
+
+void SharedStatePublisher::release(SharedStatus status) {
+    header->status.store(static_cast<uint32_t>(status), std::memory_order_release);
+    munmap(header, size);
+    shm_unlink(name.c_str());
+    header = nullptr;
+    size = 0;
+}
+
+bool SharedStatePublisher::publish(const ParticleSystem& particles, uint64_t frame, uint64_t layoutVersion) {
+    size_t count = particles.posX.size();
+    return publish(particles.planets, count, frame, layoutVersion, [&](float* posX, float* posY, float* velX, float* velY) {
+        if (count == 0) return;
+        std::memcpy(posX, particles.posX.data(), count * sizeof(float));
+        std::memcpy(posY, particles.posY.data(), count * sizeof(float));
+        std::memcpy(velX, particles.velX.data(), count * sizeof(float));
+        std::memcpy(velY, particles.velY.data(), count * sizeof(float));
+    });
+}
+
+SharedSlotHeader* SharedStatePublisher::beginFrame(const PlanetSystem& planets, size_t count, uint64_t frame, uint64_t layoutVersion) {
+    if (!header) return nullptr;
+
+    if (count > header->particleCapacity || planets.size() > header->planetCapacity) {
+        // Readers still see the old segment until they reopen by name. The
+        // request that got us here is answered by the new segment's first frame.
+        uint32_t particleCapacity = capacityFor(count, MIN_PARTICLE_CAPACITY);
+        uint32_t planetCapacity = capacityFor(planets.size(), MIN_PLANET_CAPACITY);
+        release(SharedStatus::Replaced);
+        if (!create(particleCapacity, planetCapacity)) return nullptr;
+        std::cout << "[SharedState] Grew " << name << " to " << particleCapacity << " asteroids" << std::endl;
+    }
+
+    // Requests arriving while we copy ask for the next frame
+    served = header->requested.load(std::memory_order_relaxed);
+
+    // Write the slot readers are not directed to
+    uint64_t published = header->published.load(std::memory_order_relaxed);
+    SharedSlotHeader* slot = slotAt(header, published);
+    uint64_t sequence = slot->sequence.load(std::memory_order_relaxed);
+    slot->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot->frame = frame;
+    slot->layoutVersion = layoutVersion;
+    slot->particleCount = static_cast<uint32_t>(count);
+    slot->planetCount = static_cast<uint32_t>(planets.size());
+
+    auto copy = [&](SharedArray which, const void* source, size_t entries) {
+        if (entries > 0) std::memcpy(slotArray<uint8_t>(header, slot, which), source, entries * sizeof(float));
+    };
+    copy(SharedArray::PlanetX, planets.x.data(), planets.size());
+    copy(SharedArray::PlanetY, planets.y.data(), planets.size());
+    copy(SharedArray::PlanetVX, planets.vx.data(), planets.size());
+    copy(SharedArray::PlanetVY, planets.vy.data(), planets.size());
+    copy(SharedArray::PlanetMass, planets.mass.data(), planets.size());
+    copy(SharedArray::PlanetRadius, planets.radius.data(), planets.size());
+    copy(SharedArray::PlanetColor, planets.color.data(), planets.size());
+    return slot;
+}
+
+float* SharedStatePublisher::slotFloats(SharedSlotHeader* slot, SharedArray which) const {
+    return slotArray<float>(header, slot, which);
+}
+
+void SharedStatePublisher::endFrame(SharedSlotHeader* slot) {
+    // The sequence is odd while the slot is written; one more makes it even again
+    uint64_t sequence = slot->sequence.load(std::memory_order_relaxed);
+    slot->sequence.store(sequence + 1, std::memory_order_release);
+    header->published.store(header->published.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    publishedTotal++;
+}
+
+// --- Reader ---
+
+SharedStateReader::~SharedStateReader() {
+    close();
+}
+
+bool SharedStateReader::open(const char* segment, bool quiet) {
+    close();
+    std::string path = segmentName(segment);
+
+    // Read-write: asking for frames means bumping `requested`
+    int fd = shm_open(path.c_str(), O_RDWR, 0);
+    if (fd < 0) {
+        if (!quiet) std::cerr << "[SharedState] Cannot open " << path << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    struct stat info;
+    void* mapped = MAP_FAILED;
+    if (fstat(fd, &info) == 0 && static_cast<uint64_t>(info.st_size) >= SHARED_HEADER_BYTES) {
+        mapped = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        // Also the window between the writer's ftruncate and its header
+        if (!quiet) std::cerr << "[SharedState] Cannot map " << path << std::endl;
+        return false;
+    }
+
+    SharedStateHeader* mappedHeader = static_cast<SharedStateHeader*>(mapped);
+    uint64_t expected = mappedHeader->headerSize + SHARED_STATE_SLOTS * mappedHeader->slotBytes;
+    if (std::memcmp(mappedHeader->magic, SHARED_MAGIC, sizeof(SHARED_MAGIC)) != 0 ||
+        mappedHeader->version != SHARED_STATE_VERSION || expected > static_cast<uint64_t>(info.st_size)) {
+        if (!quiet) std::cerr << "[SharedState] " << path << " is not a version " << SHARED_STATE_VERSION << " state segment" << std::endl;
+        munmap(mapped, static_cast<size_t>(info.st_size));
+        return false;
+    }
+
+    header = mappedHeader;
+    size = static_cast<size_t>(info.st_size);
+    return true;
+}
+
+void SharedStateReader::close() {
+    if (header) munmap(header, size);
+    header = nullptr;
+    size = 0;
+}
+
+void SharedStateReader::request() {
+    header->requested.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool SharedStateReader::acquire(SharedFrameView& view) const {
+    uint64_t published = header->published.load(std::memory_order_acquire);
+    if (published == 0) return false;
+
+    const SharedSlotHeader* slot = slotAt(header, published - 1);
+    uint64_t sequence = slot->sequence.load(std::memory_order_acquire);
+    if (sequence & 1) return false;
+
+    view.slot = slot;
+    view.sequence = sequence;
+    view.frame = slot->frame;
+    view.layoutVersion = slot->layoutVersion;
+    view.particleCount = static_cast<int>(std::min(slot->particleCount, header->particleCapacity));
+    view.planetCount = static_cast<int>(std::min(slot->planetCount, header->planetCapacity));
+    view.posX = slotArray<const float>(header, slot, SharedArray::PosX);
+    view.posY = slotArray<const float>(header, slot, SharedArray::PosY);
+    view.velX = slotArray<const float>(header, slot, SharedArray::VelX);
+    view.velY = slotArray<const float>(header, slot, SharedArray::VelY);
+    view.planetX = slotArray<const float>(header, slot, SharedArray::PlanetX);
+    view.planetY = slotArray<const float>(header, slot, SharedArray::PlanetY);
+    view.planetMass = slotArray<const float>(header, slot, SharedArray::PlanetMass);
+    view.planetRadius = slotArray<const float>(header, slot, SharedArray::PlanetRadius);
+    return true;
+}
+
+bool SharedStateReader::validate(const SharedFrameView& view) const {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return view.slot->sequence.load(std::memory_order_relaxed) == view.sequence;
+}
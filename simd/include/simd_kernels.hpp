@@ -0,0 +1,79 @@
+#pragma once
+
+// Explicit SIMD kernels for the asteroid hot loops.
+// One binary serves the whole fleet: the widest instruction set the CPU
+// supports (AVX-512, AVX2+FMA, SSE4.2, scalar) is picked once from CPUID.
+// Every kernel works on the particle range [begin, end) so it can be called
+// from inside a JobSystem::parallelFor chunk.
+
+#include <cstdint>
+
+// Planets in SoA form for the masked attraction kernel
+struct PlanetBatch {
+    const float* x = nullptr;
+    const float* y = nullptr;
+    const float* mass = nullptr;
+    const float* radiusSq = nullptr;
+    int count = 0;
+};
+
+// One substep over compact storage: positions are 16-bit fixed point
+// (p = q * positionStep), velocities IEEE half precision. Both are widened to
+// float in registers and narrowed with dithered rounding, because per-substep
+// increments are often smaller than one quantum and round-to-nearest would
+// drop them (or bias them the same way every substep).
+struct CompactSubstep {
+    bool centralGravity = true;
+    float starX = 0.0f, starY = 0.0f, starMass = 0.0f, softeningSq = 0.0f;
+    PlanetBatch planets;
+    float planetCutoffSq = 0.0f;
+    float dt = 0.0f, damping = 1.0f;
+    float minX = 0.0f, maxX = 0.0f, minY = 0.0f, maxY = 0.0f; // Walls
+    float restitution = 0.0f;
+    float positionStep = 1.0f;  // Domain units per position quantum
+    uint32_t ditherSeed = 0;    // Distinct per substep; the dither is a hash of (index, seed)
+};
+
+struct SimdKernels {
+    const char* name;
+
+    // v += M * d / (|d|^2 + softeningSq)^(3/2) * dt, d = star - p
+    void (*centralGravity)(const float* posX, const float* posY, float* velX, float* velY,
+                           int begin, int end, float starX, float starY, float starMass,
+                           float softeningSq, float dt);
+
+    // v += m * d / |d|^3 * dt for planets with radiusSq < |d|^2 < cutoffSq
+    void (*planetGravity)(const float* posX, const float* posY, float* velX, float* velY,
+                          int begin, int end, const PlanetBatch& planets, float cutoffSq, float dt);
+
+    // Planet-planet gravity for planets i in [begin, end) against all `count`:
+    // v_i += m_j * d / |d|^3 * dt for j with |d| > radius_i + radius_j, d = p_j - p_i.
+    // Reads positions only, so ranges of i run in parallel.
+    void (*planetPairs)(const float* x, const float* y, const float* mass, const float* radius,
+                        float* vx, float* vy, int begin, int end, int count, float dt);
+
+    // p += v * dt; v *= damping
+    void (*integrate)(float* posX, float* posY, float* velX, float* velY,
+                      int begin, int end, float dt, float damping);
+
+    // p += v * dt; integrate() for damping == 1 without rewriting v
+    void (*drift)(float* posX, float* posY, const float* velX, const float* velY, int begin, int end, float dt);
+
+    // Clamp p into [min, max] per axis; v *= -restitution on axes that were outside
+    void (*reflectWalls)(float* posX, float* posY, float* velX, float* velY,
+                         int begin, int end, float minX, float maxX, float minY, float maxY, float restitution);
+
+    // centralGravity + planetGravity + integrate + wall bounce on compact storage
+    void (*compactSubstep)(uint16_t* posX, uint16_t* posY, uint16_t* velX, uint16_t* velY,
+                           int begin, int end, const CompactSubstep& params);
+};
+
+// IEEE half conversions. floatToHalf truncates toward zero (as F16C with
+// _MM_FROUND_TO_ZERO), so adding random low mantissa bits first gives
+// stochastic rounding.
+float halfToFloat(uint16_t h);
+uint16_t floatToHalf(float f);
+
+// Kernels chosen at startup. Set PARTICLE_SIMD=scalar|sse4.2|avx2|avx512 to
+// cap the path; if the CPU lacks the requested one, the next narrower is used.
+const SimdKernels& simdKernels();
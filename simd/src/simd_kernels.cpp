@@ -0,0 +1,724 @@
+#include "simd_kernels.hpp"
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <immintrin.h>
+    #define SIMD_X86 1
+#endif
+
+namespace {
+
+// --- Scalar (reference and loop tails) ---
+
+void centralGravityScalar(const float* posX, const float* posY, float* velX, float* velY,
+                          int begin, int end, float starX, float starY, float starMass,
+                          float softeningSq, float dt) {
+    for (int i = begin; i < end; ++i) {
+        float dx = starX - posX[i];
+        float dy = starY - posY[i];
+        float distSq = dx*dx + dy*dy;
+        float dist = std::sqrt(distSq + softeningSq);
+        float force = starMass / (distSq + softeningSq);
+        velX[i] += (dx / dist) * force * dt;
+        velY[i] += (dy / dist) * force * dt;
+    }
+}
+
+void planetGravityScalar(const float* posX, const float* posY, float* velX, float* velY,
+                         int begin, int end, const PlanetBatch& planets, float cutoffSq, float dt) {
+    for (int i = begin; i < end; ++i) {
+        for (int p = 0; p < planets.count; ++p) {
+            float dx = planets.x[p] - posX[i];
+            float dy = planets.y[p] - posY[i];
+            float distSq = dx*dx + dy*dy;
+            if (distSq < cutoffSq && distSq > planets.radiusSq[p]) {
+                float dist = std::sqrt(distSq);
+                float force = planets.mass[p] / distSq;
+                velX[i] += (dx / dist) * force * dt;
+                velY[i] += (dy / dist) * force * dt;
+            }
+        }
+    }
+}
+
+void planetPairsScalar(const float* x, const float* y, const float* mass, const float* radius,
+                       float* vx, float* vy, int begin, int end, int count, float dt) {
+    for (int i = begin; i < end; ++i) {
+        float ax = 0.0f, ay = 0.0f;
+        for (int j = 0; j < count; ++j) {
+            float dx = x[j] - x[i];
+            float dy = y[j] - y[i];
+            float distSq = dx*dx + dy*dy;
+            float dist = std::sqrt(distSq);
+            // Also skips j == i: the distance is 0
+            if (dist > radius[i] + radius[j]) {
+                float force = mass[j] / distSq;
+                ax += (dx / dist) * force;
+                ay += (dy / dist) * force;
+            }
+        }
+        vx[i] += ax * dt;
+        vy[i] += ay * dt;
+    }
+}
+
+void integrateScalar(float* posX, float* posY, float* velX, float* velY,
+                     int begin, int end, float dt, float damping) {
+    for (int i = begin; i < end; ++i) {
+        posX[i] += velX[i] * dt;
+        posY[i] += velY[i] * dt;
+        velX[i] *= damping;
+        velY[i] *= damping;
+    }
+}
+
+void driftScalar(float* posX, float* posY, const float* velX, const float* velY, int begin, int end, float dt) {
+    for (int i = begin; i < end; ++i) {
+        posX[i] += velX[i] * dt;
+        posY[i] += velY[i] * dt;
+    }
+}
+
+void reflectWallsScalar(float* posX, float* posY, float* velX, float* velY,
+                        int begin, int end, float minX, float maxX, float minY, float maxY, float restitution) {
+    for (int i = begin; i < end; ++i) {
+        if (posX[i] < minX) {
+            posX[i] = minX; velX[i] *= -restitution;
+        } else if (posX[i] > maxX) {
+            posX[i] = maxX; velX[i] *= -restitution;
+        }
+        if (posY[i] < minY) {
+            posY[i] = minY; velY[i] *= -restitution;
+        } else if (posY[i] > maxY) {
+            posY[i] = maxY; velY[i] *= -restitution;
+        }
+    }
+}
+
+// --- Compact storage ---
+
+// Per-particle dither bits: byte 0/1 round posX/posY, byte 2/3 velX/velY
+inline uint32_t ditherHash(uint32_t index, uint32_t seed) {
+    uint32_t h = (index * 0x9E3779B1u) ^ seed;
+    h ^= h >> 16; h *= 0x7FEB352Du;
+    h ^= h >> 15; h *= 0x846CA68Bu;
+    h ^= h >> 16;
+    return h;
+}
+
+inline uint16_t narrowPosition(float p, float invStep, uint32_t ditherByte) {
+    float q = p * invStep + (static_cast<float>(ditherByte) + 0.5f) * (1.0f / 256.0f);
+    if (!(q > 0.0f)) return 0;
+    if (q >= 65535.0f) return 65535;
+    return static_cast<uint16_t>(q);
+}
+
+// Random bits below the half mantissa, then truncation: stochastic rounding
+inline uint16_t narrowVelocity(float v, uint32_t ditherByte) {
+    uint32_t bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    bits += (ditherByte << 5) | 16u;
+    std::memcpy(&v, &bits, sizeof(v));
+    return floatToHalf(v);
+}
+
+void compactSubstepScalar(uint16_t* posX, uint16_t* posY, uint16_t* velX, uint16_t* velY,
+                          int begin, int end, const CompactSubstep& params) {
+    const float invStep = 1.0f / params.positionStep;
+    const PlanetBatch& planets = params.planets;
+    for (int i = begin; i < end; ++i) {
+        float x = static_cast<float>(posX[i]) * params.positionStep;
+        float y = static_cast<float>(posY[i]) * params.positionStep;
+        float vx = halfToFloat(velX[i]);
+        float vy = halfToFloat(velY[i]);
+
+        if (params.centralGravity) {
+            float dx = params.starX - x;
+            float dy = params.starY - y;
+            float distSq = dx*dx + dy*dy;
+            float dist = std::sqrt(distSq + params.softeningSq);
+            float force = params.starMass / (distSq + params.softeningSq);
+            vx += (dx / dist) * force * params.dt;
+            vy += (dy / dist) * force * params.dt;
+        }
+        for (int p = 0; p < planets.count; ++p) {
+            float dx = planets.x[p] - x;
+            float dy = planets.y[p] - y;
+            float distSq = dx*dx + dy*dy;
+            if (distSq < params.planetCutoffSq && distSq > planets.radiusSq[p]) {
+                float dist = std::sqrt(distSq);
+                float force = planets.mass[p] / distSq;
+                vx += (dx / dist) * force * params.dt;
+                vy += (dy / dist) * force * params.dt;
+            }
+        }
+
+        x += vx * params.dt;
+        y += vy * params.dt;
+        vx *= params.damping;
+        vy *= params.damping;
+
+        if (x < params.minX) { x = params.minX; vx *= -params.restitution; }
+        else if (x > params.maxX) { x = params.maxX; vx *= -params.restitution; }
+        if (y < params.minY) { y = params.minY; vy *= -params.restitution; }
+        else if (y > params.maxY) { y = params.maxY; vy *= -params.restitution; }
+
+        uint32_t h = ditherHash(static_cast<uint32_t>(i), params.ditherSeed);
+        posX[i] = narrowPosition(x, invStep, h & 0xFF);
+        posY[i] = narrowPosition(y, invStep, (h >> 8) & 0xFF);
+        velX[i] = narrowVelocity(vx, (h >> 16) & 0xFF);
+        velY[i] = narrowVelocity(vy, h >> 24);
+    }
+}
+
+#ifdef SIMD_X86
+
+// --- SSE4.2 (4 lanes) ---
+
+__attribute__((target("sse4.2")))
+void centralGravitySse(const float* posX, const float* posY, float* velX, float* velY,
+                       int begin, int end, float starX, float starY, float starMass,
+                       float softeningSq, float dt) {
+    const __m128 sx = _mm_set1_ps(starX), sy = _mm_set1_ps(starY);
+    const __m128 soft = _mm_set1_ps(softeningSq), mdt = _mm_set1_ps(starMass * dt);
+    int i = begin;
+    for (; i + 4 <= end; i += 4) {
+        __m128 dx = _mm_sub_ps(sx, _mm_loadu_ps(posX + i));
+        __m128 dy = _mm_sub_ps(sy, _mm_loadu_ps(posY + i));
+        __m128 r2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), soft);
+        __m128 f = _mm_div_ps(mdt, _mm_mul_ps(r2, _mm_sqrt_ps(r2)));
+        _mm_storeu_ps(velX + i, _mm_add_ps(_mm_loadu_ps(velX + i), _mm_mul_ps(dx, f)));
+        _mm_storeu_ps(velY + i, _mm_add_ps(_mm_loadu_ps(velY + i), _mm_mul_ps(dy, f)));
+    }
+    centralGravityScalar(posX, posY, velX, velY, i, end, starX, starY, starMass, softeningSq, dt);
+}
+
+__attribute__((target("sse4.2")))
+void planetGravitySse(const float* posX, const float* posY, float* velX, float* velY,
+                      int begin, int end, const PlanetBatch& planets, float cutoffSq, float dt) {
+    const __m128 cutoff = _mm_set1_ps(cutoffSq);
+    const __m128 vdt = _mm_set1_ps(dt);
+    int i = begin;
+    for (; i + 4 <= end; i += 4) {
+        __m128 px = _mm_loadu_ps(posX + i), py = _mm_loadu_ps(posY + i);
+        __m128 ax = _mm_setzero_ps(), ay = _mm_setzero_ps();
+        for (int p = 0; p < planets.count; ++p) {
+            __m128 dx = _mm_sub_ps(_mm_set1_ps(planets.x[p]), px);
+            __m128 dy = _mm_sub_ps(_mm_set1_ps(planets.y[p]), py);
+            __m128 d2 = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+            __m128 mask = _mm_and_ps(_mm_cmplt_ps(d2, cutoff),
+                                     _mm_cmpgt_ps(d2, _mm_set1_ps(planets.radiusSq[p])));
+            if (_mm_movemask_ps(mask) == 0) continue;
+            // Masked-off lanes may divide by zero; the blend discards them
+            __m128 f = _mm_div_ps(_mm_set1_ps(planets.mass[p]), _mm_mul_ps(d2, _mm_sqrt_ps(d2)));
+            f = _mm_blendv_ps(_mm_setzero_ps(), f, mask);
+            ax = _mm_add_ps(ax, _mm_mul_ps(dx, f));
+            ay = _mm_add_ps(ay, _mm_mul_ps(dy, f));
+        }
+        _mm_storeu_ps(velX + i, _mm_add_ps(_mm_loadu_ps(velX + i), _mm_mul_ps(ax, vdt)));
+        _mm_storeu_ps(velY + i, _mm_add_ps(_mm_loadu_ps(velY + i), _mm_mul_ps(ay, vdt)));
+    }
+    planetGravityScalar(posX, posY, velX, velY, i, end, planets, cutoffSq, dt);
+}
+
+__attribute__((target("sse4.2")))
+void planetPairsSse(const float* x, const float* y, const float* mass, const float* radius,
+                    float* vx, float* vy, int begin, int end, int count, float dt) {
+    const __m128 vdt = _mm_set1_ps(dt);
+    int i = begin;
+    for (; i + 4 <= end; i += 4) {
+        __m128 px = _mm_loadu_ps(x + i), py = _mm_loadu_ps(y + i), pr = _mm_loadu_ps(radius + i);
+        __m128 ax = _mm_setzero_ps(), ay = _mm_setzero_ps();
+        for (int j = 0; j < count; ++j) {
+            __m128 dx = _mm_sub_ps(_mm_set1_ps(x[j]), px);
+            __m128 dy = _mm_sub_ps(_mm_set1_ps(y[j]), py);
+            __m128 d2 = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+            __m128 minSep = _mm_add_ps(pr, _mm_set1_ps(radius[j]));
+            __m128 mask = _mm_cmpgt_ps(d2, _mm_mul_ps(minSep, minSep));
+            if (_mm_movemask_ps(mask) == 0) continue;
+            __m128 f = _mm_div_ps(_mm_set1_ps(mass[j]), _mm_mul_ps(d2, _mm_sqrt_ps(d2)));
+            f = _mm_blendv_ps(_mm_setzero_ps(), f, mask);
+            ax = _mm_add_ps(ax, _mm_mul_ps(dx, f));
+            ay = _mm_add_ps(ay, _mm_mul_ps(dy, f));
+        }
+        _mm_storeu_ps(vx + i, _mm_add_ps(_mm_loadu_ps(vx + i), _mm_mul_ps(ax, vdt)));
+        _mm_storeu_ps(vy + i, _mm_add_ps(_mm_loadu_ps(vy + i), _mm_mul_ps(ay, vdt)));
+    }
+    planetPairsScalar(x, y, mass, radius, vx, vy, i, end, count, dt);
+}
+
+__attribute__((target("sse4.2")))
+void integrateSse(float* posX, float* posY, float* velX, float* velY,
+                  int begin, int end, float dt, float damping) {
+    const __m128 vdt = _mm_set1_ps(dt), damp = _mm_set1_ps(damping);
+    int i = begin;
+    for (; i + 4 <= end; i += 4) {
+        __m128 vx = _mm_loadu_ps(velX + i), vy = _mm_loadu_ps(velY + i);
+        _mm_storeu_ps(posX + i, _mm_add_ps(_mm_loadu_ps(posX + i), _mm_mul_ps(vx, vdt)));
+        _mm_storeu_ps(posY + i, _mm_add_ps(_mm_loadu_ps(posY + i), _mm_mul_ps(vy, vdt)));
+        _mm_storeu_ps(velX + i, _mm_mul_ps(vx, damp));
+        _mm_storeu_ps(velY + i, _mm_mul_ps(vy, damp));
+    }
+    integrateScalar(posX, posY, velX, velY, i, end, dt, damping);
+}
+
+__attribute__((target("sse4.2")))
+void driftSse(float* posX, float* posY, const float* velX, const float* velY, int begin, int end, float dt) {
+    const __m128 vdt = _mm_set1_ps(dt);
+    int i = begin;
+    for (; i + 4 <= end; i += 4) {
+        _mm_storeu_ps(posX + i, _mm_add_ps(_mm_loadu_ps(posX + i), _mm_mul_ps(_mm_loadu_ps(velX + i), vdt)));
+        _mm_storeu_ps(posY + i, _mm_add_ps(_mm_loadu_ps(posY + i), _mm_mul_ps(_mm_loadu_ps(velY + i), vdt)));
+    }
+    driftScalar(posX, posY, velX, velY, i, end, dt);
+}
+
+// min(max, max(min, p)) keeps NaN positions as they are, like the scalar branches
+__attribute__((target("sse4.2")))
+void reflectWallsSse(float* posX, float* posY, float* velX, float* velY,
+                     int begin, int end, float minX, float maxX, float minY, float maxY, float restitution) {
+    const __m128 loX = _mm_set1_ps(minX), hiX = _mm_set1_ps(maxX);
+    const __m128 loY = _mm_set1_ps(minY), hiY = _mm_set1_ps(maxY);
+    const __m128 bounce = _mm_set1_ps(-restitution);
+    int i = begin;
+    for (; i + 4 <= end; i += 4) {
+        __m128 px = _mm_loadu_ps(posX + i), py = _mm_loadu_ps(posY + i);
+        __m128 outX = _mm_or_ps(_mm_cmplt_ps(px, loX), _mm_cmpgt_ps(px, hiX));
+        __m128 outY = _mm_or_ps(_mm_cmplt_ps(py, loY), _mm_cmpgt_ps(py, hiY));
+        if (_mm_movemask_ps(_mm_or_ps(outX, outY)) == 0) continue;
+        __m128 vx = _mm_loadu_ps(velX + i), vy = _mm_loadu_ps(velY + i);
+        _mm_storeu_ps(posX + i, _mm_min_ps(hiX, _mm_max_ps(loX, px)));
+        _mm_storeu_ps(posY + i, _mm_min_ps(hiY, _mm_max_ps(loY, py)));
+        _mm_storeu_ps(velX + i, _mm_blendv_ps(vx, _mm_mul_ps(vx, bounce), outX));
+        _mm_storeu_ps(velY + i, _mm_blendv_ps(vy, _mm_mul_ps(vy, bounce), outY));
+    }
+    reflectWallsScalar(posX, posY, velX, velY, i, end, minX, maxX, minY, maxY, restitution);
+}
+
+// --- AVX2 + FMA (8 lanes) ---
+
+__attribute__((target("avx2,fma")))
+void centralGravityAvx2(const float* posX, const float* posY, float* velX, float* velY,
+                        int begin, int end, float starX, float starY, float starMass,
+                        float softeningSq, float dt) {
+    const __m256 sx = _mm256_set1_ps(starX), sy = _mm256_set1_ps(starY);
+    const __m256 soft = _mm256_set1_ps(softeningSq), mdt = _mm256_set1_ps(starMass * dt);
+    int i = begin;
+    for (; i + 8 <= end; i += 8) {
+        __m256 dx = _mm256_sub_ps(sx, _mm256_loadu_ps(posX + i));
+        __m256 dy = _mm256_sub_ps(sy, _mm256_loadu_ps(posY + i));
+        __m256 r2 = _mm256_fmadd_ps(dx, dx, _mm256_fmadd_ps(dy, dy, soft));
+        __m256 f = _mm256_div_ps(mdt, _mm256_mul_ps(r2, _mm256_sqrt_ps(r2)));
+        _mm256_storeu_ps(velX + i, _mm256_fmadd_ps(dx, f, _mm256_loadu_ps(velX + i)));
+        _mm256_storeu_ps(velY + i, _mm256_fmadd_ps(dy, f, _mm256_loadu_ps(velY + i)));
+    }
+    centralGravityScalar(posX, posY, velX, velY, i, end, starX, starY, starMass, softeningSq, dt);
+}
+
+__attribute__((target("avx2,fma")))
+void planetGravityAvx2(const float* posX, const float* posY, float* velX, float* velY,
+                       int begin, int end, const PlanetBatch& planets, float cutoffSq, float dt) {
+    const __m256 cutoff = _mm256_set1_ps(cutoffSq);
+    const __m256 vdt = _mm256_set1_ps(dt);
+    int i = begin;
+    for (; i + 8 <= end; i += 8) {
+        __m256 px = _mm256_loadu_ps(posX + i), py = _mm256_loadu_ps(posY + i);
+        __m256 ax = _mm256_setzero_ps(), ay = _mm256_setzero_ps();
+        for (int p = 0; p < planets.count; ++p) {
+            __m256 dx = _mm256_sub_ps(_mm256_set1_ps(planets.x[p]), px);
+            __m256 dy = _mm256_sub_ps(_mm256_set1_ps(planets.y[p]), py);
+            __m256 d2 = _mm256_fmadd_ps(dx, dx, _mm256_mul_ps(dy, dy));
+            __m256 mask = _mm256_and_ps(_mm256_cmp_ps(d2, cutoff, _CMP_LT_OQ),
+                                        _mm256_cmp_ps(d2, _mm256_set1_ps(planets.radiusSq[p]), _CMP_GT_OQ));
+            if (_mm256_movemask_ps(mask) == 0) continue;
+            __m256 f = _mm256_div_ps(_mm256_set1_ps(planets.mass[p]), _mm256_mul_ps(d2, _mm256_sqrt_ps(d2)));
+            f = _mm256_and_ps(f, mask);
+            ax = _mm256_fmadd_ps(dx, f, ax);
+            ay = _mm256_fmadd_ps(dy, f, ay);
+        }
+        _mm256_storeu_ps(velX + i, _mm256_fmadd_ps(ax, vdt, _mm256_loadu_ps(velX + i)));
+        _mm256_storeu_ps(velY + i, _mm256_fmadd_ps(ay, vdt, _mm256_loadu_ps(velY + i)));
+    }
+    planetGravityScalar(posX, posY, velX, velY, i, end, planets, cutoffSq, dt);
+}
+
+__attribute__((target("avx2,fma")))
+void planetPairsAvx2(const float* x, const float* y, const float* mass, const float* radius,
+                     float* vx, float* vy, int begin, int end, int count, float dt) {
+    const __m256 vdt = _mm256_set1_ps(dt);
+    int i = begin;
+    for (; i + 8 <= end; i += 8) {
+        __m256 px = _mm256_loadu_ps(x + i), py = _mm256_loadu_ps(y + i), pr = _mm256_loadu_ps(radius + i);
+        __m256 ax = _mm256_setzero_ps(), ay = _mm256_setzero_ps();
+        for (int j = 0; j < count; ++j) {
+            __m256 dx = _mm256_sub_ps(_mm256_set1_ps(x[j]), px);
+            __m256 dy = _mm256_sub_ps(_mm256_set1_ps(y[j]), py);
+            __m256 d2 = _mm256_fmadd_ps(dx, dx, _mm256_mul_ps(dy, dy));
+            __m256 minSep = _mm256_add_ps(pr, _mm256_set1_ps(radius[j]));
+            __m256 mask = _mm256_cmp_ps(d2, _mm256_mul_ps(minSep, minSep), _CMP_GT_OQ);
+            if (_mm256_movemask_ps(mask) == 0) continue;
+            __m256 f = _mm256_div_ps(_mm256_set1_ps(mass[j]), _mm256_mul_ps(d2, _mm256_sqrt_ps(d2)));
+            f = _mm256_and_ps(f, mask);
+            ax = _mm256_fmadd_ps(dx, f, ax);
+            ay = _mm256_fmadd_ps(dy, f, ay);
+        }
+        _mm256_storeu_ps(vx + i, _mm256_fmadd_ps(ax, vdt, _mm256_loadu_ps(vx + i)));
+        _mm256_storeu_ps(vy + i, _mm256_fmadd_ps(ay, vdt, _mm256_loadu_ps(vy + i)));
+    }
+    planetPairsScalar(x, y, mass, radius, vx, vy, i, end, count, dt);
+}
+
+__attribute__((target("avx2,fma")))
+void integrateAvx2(float* posX, float* posY, float* velX, float* velY,
+                   int begin, int end, float dt, float damping) {
+    const __m256 vdt = _mm256_set1_ps(dt), damp = _mm256_set1_ps(damping);
+    int i = begin;
+    for (; i + 8 <= end; i += 8) {
+        __m256 vx = _mm256_loadu_ps(velX + i), vy = _mm256_loadu_ps(velY + i);
+        _mm256_storeu_ps(posX + i, _mm256_fmadd_ps(vx, vdt, _mm256_loadu_ps(posX + i)));
+        _mm256_storeu_ps(posY + i, _mm256_fmadd_ps(vy, vdt, _mm256_loadu_ps(posY + i)));
+        _mm256_storeu_ps(velX + i, _mm256_mul_ps(vx, damp));
+        _mm256_storeu_ps(velY + i, _mm256_mul_ps(vy, damp));
+    }
+    integrateScalar(posX, posY, velX, velY, i, end, dt, damping);
+}
+
+__attribute__((target("avx2,fma")))
+void driftAvx2(float* posX, float* posY, const float* velX, const float* velY, int begin, int end, float dt) {
+    const __m256 vdt = _mm256_set1_ps(dt);
+    int i = begin;
+    for (; i + 8 <= end; i += 8) {
+        _mm256_storeu_ps(posX + i, _mm256_fmadd_ps(_mm256_loadu_ps(velX + i), vdt, _mm256_loadu_ps(posX + i)));
+        _mm256_storeu_ps(posY + i, _mm256_fmadd_ps(_mm256_loadu_ps(velY + i), vdt, _mm256_loadu_ps(posY + i)));
+    }
+    driftScalar(posX, posY, velX, velY, i, end, dt);
+}
+
+__attribute__((target("avx2,fma")))
+void reflectWallsAvx2(float* posX, float* posY, float* velX, float* velY,
+                      int begin, int end, float minX, float maxX, float minY, float maxY, float restitution) {
+    const __m256 loX = _mm256_set1_ps(minX), hiX = _mm256_set1_ps(maxX);
+    const __m256 loY = _mm256_set1_ps(minY), hiY = _mm256_set1_ps(maxY);
+    const __m256 bounce = _mm256_set1_ps(-restitution);
+    int i = begin;
+    for (; i + 8 <= end; i += 8) {
+        __m256 px = _mm256_loadu_ps(posX + i), py = _mm256_loadu_ps(posY + i);
+        __m256 outX = _mm256_or_ps(_mm256_cmp_ps(px, loX, _CMP_LT_OQ), _mm256_cmp_ps(px, hiX, _CMP_GT_OQ));
+        __m256 outY = _mm256_or_ps(_mm256_cmp_ps(py, loY, _CMP_LT_OQ), _mm256_cmp_ps(py, hiY, _CMP_GT_OQ));
+        if (_mm256_movemask_ps(_mm256_or_ps(outX, outY)) == 0) continue;
+        __m256 vx = _mm256_loadu_ps(velX + i), vy = _mm256_loadu_ps(velY + i);
+        _mm256_storeu_ps(posX + i, _mm256_min_ps(hiX, _mm256_max_ps(loX, px)));
+        _mm256_storeu_ps(posY + i, _mm256_min_ps(hiY, _mm256_max_ps(loY, py)));
+        _mm256_storeu_ps(velX + i, _mm256_blendv_ps(vx, _mm256_mul_ps(vx, bounce), outX));
+        _mm256_storeu_ps(velY + i, _mm256_blendv_ps(vy, _mm256_mul_ps(vy, bounce), outY));
+    }
+    reflectWallsScalar(posX, posY, velX, velY, i, end, minX, maxX, minY, maxY, restitution);
+}
+
+__attribute__((target("avx2,fma,f16c")))
+inline __m256 loadPositionAvx2(const uint16_t* src, __m256 step) {
+    __m256i q = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src)));
+    return _mm256_mul_ps(_mm256_cvtepi32_ps(q), step);
+}
+
+__attribute__((target("avx2,fma,f16c")))
+inline void storePositionAvx2(uint16_t* dst, __m256 p, __m256 invStep, __m256i ditherByte) {
+    __m256 u = _mm256_mul_ps(_mm256_add_ps(_mm256_cvtepi32_ps(ditherByte), _mm256_set1_ps(0.5f)),
+                             _mm256_set1_ps(1.0f / 256.0f));
+    __m256i q = _mm256_cvttps_epi32(_mm256_fmadd_ps(p, invStep, u));
+    // Saturating pack clamps to [0, 65535]; the permute gathers both 128-bit halves
+    __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(q, q), 0x08);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm256_castsi256_si128(packed));
+}
+
+__attribute__((target("avx2,fma,f16c")))
+inline void storeVelocityAvx2(uint16_t* dst, __m256 v, __m256i ditherByte) {
+    __m256i dither = _mm256_or_si256(_mm256_slli_epi32(ditherByte, 5), _mm256_set1_epi32(16));
+    __m256i bits = _mm256_add_epi32(_mm256_castps_si256(v), dither);
+    __m128i h = _mm256_cvtps_ph(_mm256_castsi256_ps(bits), _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), h);
+}
+
+// F16C ships with every AVX2 CPU, so the AVX2 and AVX-512 tables share this
+__attribute__((target("avx2,fma,f16c")))
+void compactSubstepAvx2(uint16_t* posX, uint16_t* posY, uint16_t* velX, uint16_t* velY,
+                        int begin, int end, const CompactSubstep& params) {
+    const __m256 step = _mm256_set1_ps(params.positionStep);
+    const __m256 invStep = _mm256_set1_ps(1.0f / params.positionStep);
+    const __m256 sx = _mm256_set1_ps(params.starX), sy = _mm256_set1_ps(params.starY);
+    const __m256 soft = _mm256_set1_ps(params.softeningSq);
+    const __m256 mdt = _mm256_set1_ps(params.starMass * params.dt);
+    const __m256 cutoff = _mm256_set1_ps(params.planetCutoffSq);
+    const __m256 vdt = _mm256_set1_ps(params.dt), damp = _mm256_set1_ps(params.damping);
+    const __m256 minX = _mm256_set1_ps(params.minX), maxX = _mm256_set1_ps(params.maxX);
+    const __m256 minY = _mm256_set1_ps(params.minY), maxY = _mm256_set1_ps(params.maxY);
+    const __m256 bounce = _mm256_set1_ps(-params.restitution);
+    const __m256i byteMask = _mm256_set1_epi32(0xFF);
+    const __m256i seed = _mm256_set1_epi32(static_cast<int>(params.ditherSeed));
+    const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const PlanetBatch& planets = params.planets;
+
+    int i = begin;
+    for (; i + 8 <= end; i += 8) {
+        __m256 px = loadPositionAvx2(posX + i, step), py = loadPositionAvx2(posY + i, step);
+        __m256 vx = _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(velX + i)));
+        __m256 vy = _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(velY + i)));
+
+        if (params.centralGravity) {
+            __m256 dx = _mm256_sub_ps(sx, px);
+            __m256 dy = _mm256_sub_ps(sy, py);
+            __m256 r2 = _mm256_fmadd_ps(dx, dx, _mm256_fmadd_ps(dy, dy, soft));
+            __m256 f = _mm256_div_ps(mdt, _mm256_mul_ps(r2, _mm256_sqrt_ps(r2)));
+            vx = _mm256_fmadd_ps(dx, f, vx);
+            vy = _mm256_fmadd_ps(dy, f, vy);
+        }
+        __m256 ax = _mm256_setzero_ps(), ay = _mm256_setzero_ps();
+        for (int p = 0; p < planets.count; ++p) {
+            __m256 dx = _mm256_sub_ps(_mm256_set1_ps(planets.x[p]), px);
+            __m256 dy = _mm256_sub_ps(_mm256_set1_ps(planets.y[p]), py);
+            __m256 d2 = _mm256_fmadd_ps(dx, dx, _mm256_mul_ps(dy, dy));
+            __m256 mask = _mm256_and_ps(_mm256_cmp_ps(d2, cutoff, _CMP_LT_OQ),
+                                        _mm256_cmp_ps(d2, _mm256_set1_ps(planets.radiusSq[p]), _CMP_GT_OQ));
+            if (_mm256_movemask_ps(mask) == 0) continue;
+            __m256 f = _mm256_div_ps(_mm256_set1_ps(planets.mass[p]), _mm256_mul_ps(d2, _mm256_sqrt_ps(d2)));
+            f = _mm256_and_ps(f, mask);
+            ax = _mm256_fmadd_ps(dx, f, ax);
+            ay = _mm256_fmadd_ps(dy, f, ay);
+        }
+        vx = _mm256_fmadd_ps(ax, vdt, vx);
+        vy = _mm256_fmadd_ps(ay, vdt, vy);
+
+        px = _mm256_fmadd_ps(vx, vdt, px);
+        py = _mm256_fmadd_ps(vy, vdt, py);
+        vx = _mm256_mul_ps(vx, damp);
+        vy = _mm256_mul_ps(vy, damp);
+
+        __m256 hitX = _mm256_or_ps(_mm256_cmp_ps(px, minX, _CMP_LT_OQ), _mm256_cmp_ps(px, maxX, _CMP_GT_OQ));
+        __m256 hitY = _mm256_or_ps(_mm256_cmp_ps(py, minY, _CMP_LT_OQ), _mm256_cmp_ps(py, maxY, _CMP_GT_OQ));
+        px = _mm256_min_ps(_mm256_max_ps(px, minX), maxX);
+        py = _mm256_min_ps(_mm256_max_ps(py, minY), maxY);
+        vx = _mm256_blendv_ps(vx, _mm256_mul_ps(vx, bounce), hitX);
+        vy = _mm256_blendv_ps(vy, _mm256_mul_ps(vy, bounce), hitY);
+
+        // ditherHash on 8 indices at once
+        __m256i h = _mm256_xor_si256(_mm256_mullo_epi32(_mm256_add_epi32(_mm256_set1_epi32(i), lanes),
+                                                        _mm256_set1_epi32(static_cast<int>(0x9E3779B1u))), seed);
+        h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 16));
+        h = _mm256_mullo_epi32(h, _mm256_set1_epi32(0x7FEB352D));
+        h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 15));
+        h = _mm256_mullo_epi32(h, _mm256_set1_epi32(static_cast<int>(0x846CA68Bu)));
+        h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 16));
+
+        storePositionAvx2(posX + i, px, invStep, _mm256_and_si256(h, byteMask));
+        storePositionAvx2(posY + i, py, invStep, _mm256_and_si256(_mm256_srli_epi32(h, 8), byteMask));
+        storeVelocityAvx2(velX + i, vx, _mm256_and_si256(_mm256_srli_epi32(h, 16), byteMask));
+        storeVelocityAvx2(velY + i, vy, _mm256_srli_epi32(h, 24));
+    }
+    compactSubstepScalar(posX, posY, velX, velY, i, end, params);
+}
+
+// --- AVX-512 (16 lanes, mask registers) ---
+
+// GCC 12 flags the self-initialised __Y in _mm512_undefined_ps, which the
+// unmasked sqrt/min/max intrinsics expand through (GCC bug 105593)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+
+__attribute__((target("avx512f")))
+void centralGravityAvx512(const float* posX, const float* posY, float* velX, float* velY,
+                          int begin, int end, float starX, float starY, float starMass,
+                          float softeningSq, float dt) {
+    const __m512 sx = _mm512_set1_ps(starX), sy = _mm512_set1_ps(starY);
+    const __m512 soft = _mm512_set1_ps(softeningSq), mdt = _mm512_set1_ps(starMass * dt);
+    int i = begin;
+    for (; i + 16 <= end; i += 16) {
+        __m512 dx = _mm512_sub_ps(sx, _mm512_loadu_ps(posX + i));
+        __m512 dy = _mm512_sub_ps(sy, _mm512_loadu_ps(posY + i));
+        __m512 r2 = _mm512_fmadd_ps(dx, dx, _mm512_fmadd_ps(dy, dy, soft));
+        __m512 f = _mm512_div_ps(mdt, _mm512_mul_ps(r2, _mm512_sqrt_ps(r2)));
+        _mm512_storeu_ps(velX + i, _mm512_fmadd_ps(dx, f, _mm512_loadu_ps(velX + i)));
+        _mm512_storeu_ps(velY + i, _mm512_fmadd_ps(dy, f, _mm512_loadu_ps(velY + i)));
+    }
+    centralGravityScalar(posX, posY, velX, velY, i, end, starX, starY, starMass, softeningSq, dt);
+}
+
+__attribute__((target("avx512f")))
+void planetGravityAvx512(const float* posX, const float* posY, float* velX, float* velY,
+                         int begin, int end, const PlanetBatch& planets, float cutoffSq, float dt) {
+    const __m512 cutoff = _mm512_set1_ps(cutoffSq);
+    const __m512 vdt = _mm512_set1_ps(dt);
+    int i = begin;
+    for (; i + 16 <= end; i += 16) {
+        __m512 px = _mm512_loadu_ps(posX + i), py = _mm512_loadu_ps(posY + i);
+        __m512 ax = _mm512_setzero_ps(), ay = _mm512_setzero_ps();
+        for (int p = 0; p < planets.count; ++p) {
+            __m512 dx = _mm512_sub_ps(_mm512_set1_ps(planets.x[p]), px);
+            __m512 dy = _mm512_sub_ps(_mm512_set1_ps(planets.y[p]), py);
+            __m512 d2 = _mm512_fmadd_ps(dx, dx, _mm512_mul_ps(dy, dy));
+            __mmask16 mask = _mm512_cmp_ps_mask(d2, cutoff, _CMP_LT_OQ)
+                           & _mm512_cmp_ps_mask(d2, _mm512_set1_ps(planets.radiusSq[p]), _CMP_GT_OQ);
+            if (mask == 0) continue;
+            // Only active lanes are computed; the rest keep their accumulators
+            __m512 f = _mm512_maskz_div_ps(mask, _mm512_set1_ps(planets.mass[p]),
+                                           _mm512_mul_ps(d2, _mm512_sqrt_ps(d2)));
+            ax = _mm512_mask3_fmadd_ps(dx, f, ax, mask);
+            ay = _mm512_mask3_fmadd_ps(dy, f, ay, mask);
+        }
+        _mm512_storeu_ps(velX + i, _mm512_fmadd_ps(ax, vdt, _mm512_loadu_ps(velX + i)));
+        _mm512_storeu_ps(velY + i, _mm512_fmadd_ps(ay, vdt, _mm512_loadu_ps(velY + i)));
+    }
+    planetGravityScalar(posX, posY, velX, velY, i, end, planets, cutoffSq, dt);
+}
+
+__attribute__((target("avx512f")))
+void planetPairsAvx512(const float* x, const float* y, const float* mass, const float* radius,
+                       float* vx, float* vy, int begin, int end, int count, float dt) {
+    const __m512 vdt = _mm512_set1_ps(dt);
+    int i = begin;
+    for (; i + 16 <= end; i += 16) {
+        __m512 px = _mm512_loadu_ps(x + i), py = _mm512_loadu_ps(y + i), pr = _mm512_loadu_ps(radius + i);
+        __m512 ax = _mm512_setzero_ps(), ay = _mm512_setzero_ps();
+        for (int j = 0; j < count; ++j) {
+            __m512 dx = _mm512_sub_ps(_mm512_set1_ps(x[j]), px);
+            __m512 dy = _mm512_sub_ps(_mm512_set1_ps(y[j]), py);
+            __m512 d2 = _mm512_fmadd_ps(dx, dx, _mm512_mul_ps(dy, dy));
+            __m512 minSep = _mm512_add_ps(pr, _mm512_set1_ps(radius[j]));
+            __mmask16 mask = _mm512_cmp_ps_mask(d2, _mm512_mul_ps(minSep, minSep), _CMP_GT_OQ);
+            if (mask == 0) continue;
+            __m512 f = _mm512_maskz_div_ps(mask, _mm512_set1_ps(mass[j]),
+                                           _mm512_mul_ps(d2, _mm512_sqrt_ps(d2)));
+            ax = _mm512_mask3_fmadd_ps(dx, f, ax, mask);
+            ay = _mm512_mask3_fmadd_ps(dy, f, ay, mask);
+        }
+        _mm512_storeu_ps(vx + i, _mm512_fmadd_ps(ax, vdt, _mm512_loadu_ps(vx + i)));
+        _mm512_storeu_ps(vy + i, _mm512_fmadd_ps(ay, vdt, _mm512_loadu_ps(vy + i)));
+    }
+    planetPairsScalar(x, y, mass, radius, vx, vy, i, end, count, dt);
+}
+
+__attribute__((target("avx512f")))
+void integrateAvx512(float* posX, float* posY, float* velX, float* velY,
+                     int begin, int end, float dt, float damping) {
+    const __m512 vdt = _mm512_set1_ps(dt), damp = _mm512_set1_ps(damping);
+    int i = begin;
+    for (; i + 16 <= end; i += 16) {
+        __m512 vx = _mm512_loadu_ps(velX + i), vy = _mm512_loadu_ps(velY + i);
+        _mm512_storeu_ps(posX + i, _mm512_fmadd_ps(vx, vdt, _mm512_loadu_ps(posX + i)));
+        _mm512_storeu_ps(posY + i, _mm512_fmadd_ps(vy, vdt, _mm512_loadu_ps(posY + i)));
+        _mm512_storeu_ps(velX + i, _mm512_mul_ps(vx, damp));
+        _mm512_storeu_ps(velY + i, _mm512_mul_ps(vy, damp));
+    }
+    integrateScalar(posX, posY, velX, velY, i, end, dt, damping);
+}
+
+__attribute__((target("avx512f")))
+void driftAvx512(float* posX, float* posY, const float* velX, const float* velY, int begin, int end, float dt) {
+    const __m512 vdt = _mm512_set1_ps(dt);
+    int i = begin;
+    for (; i + 16 <= end; i += 16) {
+        _mm512_storeu_ps(posX + i, _mm512_fmadd_ps(_mm512_loadu_ps(velX + i), vdt, _mm512_loadu_ps(posX + i)));
+        _mm512_storeu_ps(posY + i, _mm512_fmadd_ps(_mm512_loadu_ps(velY + i), vdt, _mm512_loadu_ps(posY + i)));
+    }
+    driftScalar(posX, posY, velX, velY, i, end, dt);
+}
+
+__attribute__((target("avx512f")))
+void reflectWallsAvx512(float* posX, float* posY, float* velX, float* velY,
+                        int begin, int end, float minX, float maxX, float minY, float maxY, float restitution) {
+    const __m512 loX = _mm512_set1_ps(minX), hiX = _mm512_set1_ps(maxX);
+    const __m512 loY = _mm512_set1_ps(minY), hiY = _mm512_set1_ps(maxY);
+    const __m512 bounce = _mm512_set1_ps(-restitution);
+    int i = begin;
+    for (; i + 16 <= end; i += 16) {
+        __m512 px = _mm512_loadu_ps(posX + i), py = _mm512_loadu_ps(posY + i);
+        __mmask16 outX = _mm512_cmp_ps_mask(px, loX, _CMP_LT_OQ) | _mm512_cmp_ps_mask(px, hiX, _CMP_GT_OQ);
+        __mmask16 outY = _mm512_cmp_ps_mask(py, loY, _CMP_LT_OQ) | _mm512_cmp_ps_mask(py, hiY, _CMP_GT_OQ);
+        if ((outX | outY) == 0) continue;
+        _mm512_storeu_ps(posX + i, _mm512_min_ps(hiX, _mm512_max_ps(loX, px)));
+        _mm512_storeu_ps(posY + i, _mm512_min_ps(hiY, _mm512_max_ps(loY, py)));
+        __m512 vx = _mm512_loadu_ps(velX + i), vy = _mm512_loadu_ps(velY + i);
+        _mm512_storeu_ps(velX + i, _mm512_mask_mul_ps(vx, outX, vx, bounce));
+        _mm512_storeu_ps(velY + i, _mm512_mask_mul_ps(vy, outY, vy, bounce));
+    }
+    reflectWallsScalar(posX, posY, velX, velY, i, end, minX, maxX, minY, maxY, restitution);
+}
+
+#pragma GCC diagnostic pop
+
+#endif // SIMD_X86
+
+const SimdKernels scalarKernels = { "scalar", centralGravityScalar, planetGravityScalar, planetPairsScalar,
+                                    integrateScalar, driftScalar, reflectWallsScalar, compactSubstepScalar };
+#ifdef SIMD_X86
+const SimdKernels sseKernels = { "sse4.2", centralGravitySse, planetGravitySse, planetPairsSse,
+                                 integrateSse, driftSse, reflectWallsSse, compactSubstepScalar };
+const SimdKernels avx2Kernels = { "avx2", centralGravityAvx2, planetGravityAvx2, planetPairsAvx2,
+                                  integrateAvx2, driftAvx2, reflectWallsAvx2, compactSubstepAvx2 };
+const SimdKernels avx512Kernels = { "avx512", centralGravityAvx512, planetGravityAvx512, planetPairsAvx512,
+                                    integrateAvx512, driftAvx512, reflectWallsAvx512, compactSubstepAvx2 };
+#endif
+
+const SimdKernels& selectKernels() {
+    const char* forced = std::getenv("PARTICLE_SIMD");
+    auto allowed = [forced](const char* name) {
+        if (!forced) return true;
+        // A forced level caps the search; wider paths are skipped
+        const char* order[] = { "avx512", "avx2", "sse4.2", "scalar" };
+        for (const char* level : order) {
+            if (std::strcmp(level, forced) == 0) return true;
+            if (std::strcmp(level, name) == 0) return false;
+        }
+        return true;
+    };
+
+#ifdef SIMD_X86
+    __builtin_cpu_init();
+    if (allowed("avx512") && __builtin_cpu_supports("avx512f")) return avx512Kernels;
+    if (allowed("avx2") && __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return avx2Kernels;
+    if (allowed("sse4.2") && __builtin_cpu_supports("sse4.2")) return sseKernels;
+#endif
+    (void)allowed;
+    return scalarKernels;
+}
+
+} // namespace
+
+float halfToFloat(uint16_t h) {
+    uint32_t sign = static_cast<uint32_t>(h & 0x8000u) << 16;
+    uint32_t exponent = (h >> 10) & 0x1Fu;
+    uint32_t mantissa = h & 0x3FFu;
+    float f;
+    if (exponent == 0) {
+        f = static_cast<float>(mantissa) * (1.0f / 16777216.0f); // Zero and subnormals
+        return sign ? -f : f;
+    }
+    uint32_t bits = exponent == 31 ? sign | 0x7F800000u | (mantissa << 13)
+                                   : sign | ((exponent + 112) << 23) | (mantissa << 13);
+    std::memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+uint16_t floatToHalf(float f) {
+    uint32_t bits;
+    std::memcpy(&bits, &f, sizeof(bits));
+    uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000u);
+    uint32_t magnitude = bits & 0x7FFFFFFFu;
+
+    if (magnitude >= 0x7F800000u) return sign | (magnitude > 0x7F800000u ? 0x7E00 : 0x7C00); // NaN, Inf
+    if (magnitude >= 0x47800000u) return sign | 0x7BFF; // Toward zero: saturate at 65504
+
+    int exponent = static_cast<int>(magnitude >> 23) - 127 + 15;
+    if (exponent > 0) {
+        return sign | static_cast<uint16_t>((exponent << 10) | ((magnitude >> 13) & 0x3FFu));
+    }
+    int shift = 14 - exponent;
+    if (shift > 24) return sign;
+    return sign | static_cast<uint16_t>(((magnitude & 0x7FFFFFu) | 0x800000u) >> shift);
+}
+
+const SimdKernels& simdKernels() {
+    static const SimdKernels& kernels = selectKernels();
+    return kernels;
+}
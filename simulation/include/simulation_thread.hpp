@@ -0,0 +1,103 @@
+#pragma once
+
+#include "particle.hpp"
+#include "common.hpp"
+#include "spatial_grid.hpp"
+#include "shared_state.hpp"
+#include "triple_buffer.hpp"
+#include "spsc_queue.hpp"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+class ParticleKinematics;
+
+// Immutable view of the simulation handed to the render thread
+struct SimSnapshot {
+    ParticleSystem particles;       // Asteroids, in cell order while `cells` is filled
+    ParticleCells cells;            // Empty unless the UI reported a zoomed-in view
+    int particleCount = 0;
+    uint64_t frame = 0;             // Steps taken so far
+    uint64_t appliedCommand = 0;    // Sequence number of the last command processed
+    double stepsPerSecond = 0.0;
+    SimConfig config;               // Settings in effect
+    uint64_t configGeneration = 0;  // Bumped when the simulation replaces its settings (checkpoint load)
+};
+
+// Discrete UI events. Continuous settings travel through the config mailbox.
+struct SimCommand {
+    enum class Type { Spawn, Resize, SaveCheckpoint, LoadCheckpoint };
+
+    Type type = Type::Spawn;
+    uint64_t sequence = 0;
+    SimConfig config;    // Spawn: spawner settings and click position. Checkpoints: path
+    int particleCount = 0; // Resize: requested asteroid count
+};
+
+// UI settings tagged with the config generation they were edited against
+struct SimSettings {
+    SimConfig config;
+    uint64_t generation = 0;
+    bool viewZoomed = false;        // The renderer shows part of the box: index snapshots by cell
+};
+
+// Runs ParticleKinematics on its own thread at a fixed timestep.
+// The UI thread never touches the simulation state directly: it submits its
+// SimConfig every frame and reads back the latest published snapshot.
+class SimulationThread {
+    public:
+        SimulationThread(const SimConfig& initialConfig, float fixedDt);
+        ~SimulationThread();
+
+        // Before start(): also publish to POSIX shared memory when a reader asks
+        void exportSharedState(const char* name) { sharedStateName = name; }
+
+        void start();
+        void stop();
+
+        // UI thread: forwards edits of uiConfig, turns spawn clicks, checkpoint
+        // requests and particle-count changes into commands, and keeps uiConfig
+        // in sync with asteroids spawned and checkpoints loaded by the simulation.
+        // viewZoomed asks for snapshots with a cell index (see SimSnapshot::cells).
+        void submit(SimConfig& uiConfig, bool viewZoomed = false);
+
+        // UI thread: swaps in the newest snapshot if one was published
+        bool acquireSnapshot();
+        const SimSnapshot& snapshot() const { return snapshots.readSlot(); }
+
+    private:
+        void run();
+        void applyCommand(const SimCommand& command, ParticleSystem& particles, ParticleKinematics& kinematics);
+        void applySettings(const SimSettings& settings);
+        void publishSnapshot(ParticleKinematics& kinematics, const ParticleSystem& particles, double stepsPerSecond);
+
+        static constexpr float SNAPSHOT_CELL = 2.5f;   // Snapshot index cell size (simulation units)
+
+        const float fixedDt;
+
+        std::thread worker;
+        std::atomic<bool> running{false};
+
+        // --- Simulation-thread state ---
+        SimConfig config;
+        uint64_t frame = 0;
+        uint64_t appliedCommand = 0;
+        uint64_t configGeneration = 0;
+        bool cellOrder = false;         // Publish asteroids in cell order (view zoomed in)
+        SpatialGrid snapshotGrid;
+        std::string sharedStateName;
+        SharedStatePublisher sharedState;
+
+        // --- Channels ---
+        TripleBuffer<SimSnapshot> snapshots;   // Simulation -> UI
+        TripleBuffer<SimSettings> settingsMailbox; // UI -> simulation (latest wins)
+        SpscQueue<SimCommand, 64> commands;    // UI -> simulation (every event)
+
+        // --- UI-thread bookkeeping ---
+        bool hasSnapshot = false;
+        uint64_t nextSequence = 1;
+        uint64_t lastResizeSequence = 0;
+        int requestedParticleCount = 0;
+        uint64_t uiConfigGeneration = 0;
+};
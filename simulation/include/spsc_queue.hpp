@@ -0,0 +1,34 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+// Bounded lock-free single-producer/single-consumer ring buffer.
+// Capacity must be a power of two.
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+    public:
+        // Returns false when the queue is full
+        bool push(const T& value) {
+            size_t tail = writeIndex.load(std::memory_order_relaxed);
+            if (tail - readIndex.load(std::memory_order_acquire) == Capacity) return false;
+            items[tail & (Capacity - 1)] = value;
+            writeIndex.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool pop(T& value) {
+            size_t head = readIndex.load(std::memory_order_relaxed);
+            if (head == writeIndex.load(std::memory_order_acquire)) return false;
+            value = items[head & (Capacity - 1)];
+            readIndex.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+    private:
+        T items[Capacity];
+        alignas(64) std::atomic<size_t> writeIndex{0};
+        alignas(64) std::atomic<size_t> readIndex{0};
+};
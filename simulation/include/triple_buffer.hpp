@@ -0,0 +1,43 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Lock-free single-producer/single-consumer triple buffer.
+// The writer fills its private back slot and publishes it by swapping it with
+// the shared middle slot; the reader swaps the middle slot into its private
+// front slot whenever a fresh one is waiting. Neither side ever blocks, and
+// the reader always sees the most recently published value.
+template <typename T>
+class TripleBuffer {
+    public:
+        // --- Writer side ---
+        T& writeSlot() { return slots[backIndex]; }
+
+        void publish() {
+            uint8_t previous = middle.exchange(backIndex | FRESH, std::memory_order_acq_rel);
+            backIndex = previous & INDEX_MASK;
+        }
+
+        // True while the last published value has not been picked up yet
+        bool pending() const { return (middle.load(std::memory_order_acquire) & FRESH) != 0; }
+
+        // --- Reader side ---
+        bool acquire() {
+            if (!pending()) return false;
+            uint8_t previous = middle.exchange(frontIndex, std::memory_order_acq_rel);
+            frontIndex = previous & INDEX_MASK;
+            return true;
+        }
+
+        const T& readSlot() const { return slots[frontIndex]; }
+
+    private:
+        static constexpr uint8_t INDEX_MASK = 0x3;
+        static constexpr uint8_t FRESH = 0x4;
+
+        T slots[3];
+        uint8_t backIndex = 0;   // Owned by the writer
+        uint8_t frontIndex = 1;  // Owned by the reader
+        std::atomic<uint8_t> middle{2};
+};
@@ -0,0 +1,277 @@
+#include "simulation_thread.hpp"
+#include "kinematics.hpp"
+#include "checkpoint.hpp"
+#include "trajectory_recorder.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+SimulationThread::SimulationThread(const SimConfig& initialConfig, float fixedDt)
+    : fixedDt(fixedDt), config(initialConfig), requestedParticleCount(initialConfig.particleCount) {
+    config.spawnClick = false;
+    snapshotGrid.resize(static_cast<int>(SIM_WIDTH / SNAPSHOT_CELL), static_cast<int>(SIM_HEIGHT / SNAPSHOT_CELL),
+                        SNAPSHOT_CELL);
+}
+
+SimulationThread::~SimulationThread() {
+    stop();
+}
+
+void SimulationThread::start() {
+    if (running.exchange(true)) return;
+    worker = std::thread(&SimulationThread::run, this);
+}
+
+void SimulationThread::stop() {
+    running.store(false);
+    if (worker.joinable()) worker.join();
+}
+
+namespace {
+    bool pushCommand(SpscQueue<SimCommand, 64>& queue, SimCommand::Type type, uint64_t sequence, const SimConfig& config) {
+        SimCommand command;
+        command.type = type;
+        command.sequence = sequence;
+        command.config = config;
+        return queue.push(command);
+    }
+}
+
+void SimulationThread::submit(SimConfig& uiConfig, bool viewZoomed) {
+    // 1. A loaded checkpoint replaced the simulation's settings: show them
+    const SimSnapshot& latest = snapshot();
+    if (hasSnapshot && latest.configGeneration != uiConfigGeneration) {
+        uiConfig = latest.config;
+        requestedParticleCount = uiConfig.particleCount;
+        uiConfigGeneration = latest.configGeneration;
+    }
+
+    // 2. Adopt the simulation's asteroid count (spawns grow it) unless the
+    //    user is mid-edit or a resize has not been applied yet
+    if (hasSnapshot && latest.appliedCommand >= lastResizeSequence &&
+        uiConfig.particleCount == requestedParticleCount) {
+        uiConfig.particleCount = requestedParticleCount = latest.particleCount;
+    }
+
+    // 3. Discrete events
+    if (uiConfig.spawnClick) {
+        if (!pushCommand(commands, SimCommand::Type::Spawn, nextSequence++, uiConfig)) {
+            std::cerr << "[SimulationThread] Command queue full, spawn dropped" << std::endl;
+        }
+        uiConfig.spawnClick = false;
+    }
+
+    if (uiConfig.saveCheckpoint) {
+        if (!pushCommand(commands, SimCommand::Type::SaveCheckpoint, nextSequence++, uiConfig)) {
+            std::cerr << "[SimulationThread] Command queue full, checkpoint save dropped" << std::endl;
+        }
+        uiConfig.saveCheckpoint = false;
+    }
+
+    if (uiConfig.loadCheckpoint) {
+        if (!pushCommand(commands, SimCommand::Type::LoadCheckpoint, nextSequence++, uiConfig)) {
+            std::cerr << "[SimulationThread] Command queue full, checkpoint load dropped" << std::endl;
+        }
+        uiConfig.loadCheckpoint = false;
+    }
+
+    if (uiConfig.particleCount != requestedParticleCount) {
+        SimCommand command;
+        command.type = SimCommand::Type::Resize;
+        command.sequence = nextSequence++;
+        command.particleCount = uiConfig.particleCount;
+        if (commands.push(command)) {
+            requestedParticleCount = uiConfig.particleCount;
+            lastResizeSequence = command.sequence;
+        }
+    }
+
+    // 4. Continuous settings: only the latest value matters
+    SimSettings& settings = settingsMailbox.writeSlot();
+    settings.config = uiConfig;
+    settings.generation = uiConfigGeneration;
+    settings.viewZoomed = viewZoomed;
+    settingsMailbox.publish();
+}
+
+bool SimulationThread::acquireSnapshot() {
+    if (!snapshots.acquire()) return false;
+    hasSnapshot = true;
+    return true;
+}
+
+void SimulationThread::applySettings(const SimSettings& settings) {
+    cellOrder = settings.viewZoomed;
+
+    // Edits made before the UI saw a checkpoint load would undo it
+    if (settings.generation != configGeneration) return;
+
+    // particleCount and the spawn event are owned by the simulation side
+    int particleCount = config.particleCount;
+    bool spawnClick = config.spawnClick;
+    config = settings.config;
+    config.particleCount = particleCount;
+    config.spawnClick = spawnClick;
+}
+
+void SimulationThread::applyCommand(const SimCommand& command, ParticleSystem& particles, ParticleKinematics& kinematics) {
+    switch (command.type) {
+        case SimCommand::Type::Spawn: {
+            int particleCount = config.particleCount;
+            config = command.config;
+            config.particleCount = particleCount;
+            config.spawnClick = true;
+            break;
+        }
+        case SimCommand::Type::Resize:
+            config.particleCount = command.particleCount;
+            break;
+        case SimCommand::Type::SaveCheckpoint:
+            kinematics.syncParticles();
+            saveCheckpoint(command.config.checkpointPath, particles, config, frame);
+            kinematics.releaseParticles();
+            break;
+        case SimCommand::Type::LoadCheckpoint: {
+            MappedCheckpoint checkpoint;
+            if (!checkpoint.open(command.config.checkpointPath)) break;
+
+            // Pause, threads and recording belong to this session, not the file
+            SimConfig session = config;
+            checkpoint.restore(particles, config);
+            config.paused = session.paused;
+            config.workerThreads = session.workerThreads;
+            config.recordTrajectory = session.recordTrajectory;
+            std::memcpy(config.trajectoryPath, session.trajectoryPath, sizeof(config.trajectoryPath));
+
+            frame = checkpoint.frame();
+            kinematics.adoptState(frame);
+            configGeneration++;
+            std::cout << "[SimulationThread] Loaded " << config.particleCount << " particles (frame "
+                      << frame << ") from " << command.config.checkpointPath << std::endl;
+            break;
+        }
+    }
+    appliedCommand = command.sequence;
+}
+
+void SimulationThread::publishSnapshot(ParticleKinematics& kinematics, const ParticleSystem& particles, double stepsPerSecond) {
+    SimSnapshot& slot = snapshots.writeSlot();
+
+    // Asteroids go straight into the slot, widened there in compact mode, so
+    // no float mirror is kept. resize() reuses the slot's capacity: no
+    // allocation in steady state.
+    kinematics.copyAsteroids(slot.particles);
+    int count = static_cast<int>(slot.particles.posX.size());
+    slot.particles.planets = particles.planets;
+
+    ParticleCells& cells = slot.cells;
+    if (!cellOrder) {
+        // The whole box is on screen, so every asteroid is drawn anyway:
+        // no index for the renderer to consult
+        cells.cellStart.clear();
+    } else {
+        // Zoomed in: copied again in cell order, so the renderer can read
+        // just the cells the view overlaps
+        snapshotGrid.build(slot.particles.posX.data(), slot.particles.posY.data(), count);
+        kinematics.copyAsteroids(slot.particles, snapshotGrid.sortedIndices.data());
+
+        cells.cellsX = snapshotGrid.getWidth();
+        cells.cellsY = snapshotGrid.getHeight();
+        cells.cellSize = SNAPSHOT_CELL;
+        cells.cellStart.resize(snapshotGrid.cellCountTotal() + 1);
+        std::copy(snapshotGrid.cellStart.begin(), snapshotGrid.cellStart.end(), cells.cellStart.begin());
+        cells.cellStart.back() = count;
+    }
+
+    slot.particleCount = config.particleCount;
+    slot.frame = frame;
+    slot.appliedCommand = appliedCommand;
+    slot.stepsPerSecond = stepsPerSecond;
+    slot.config = config;
+    slot.configGeneration = configGeneration;
+    snapshots.publish();
+}
+
+void SimulationThread::run() {
+    using Clock = std::chrono::steady_clock;
+
+    ParticleSystem particles;
+    ParticleKinematics kinematics(particles, config.workerThreads);
+    kinematics.init(config);
+    publishSnapshot(kinematics, particles, 0.0);
+    if (!sharedStateName.empty()) sharedState.open(sharedStateName.c_str());
+
+    TrajectoryRecorder recorder;
+    bool recordRequested = false;
+
+    Clock::time_point nextStep = Clock::now();
+    Clock::time_point rateWindowStart = nextStep;
+    int rateWindowSteps = 0;
+    double stepsPerSecond = 0.0;
+
+    while (running.load(std::memory_order_relaxed)) {
+        // 1. Inbound messages. A spawn ends the drain so each click gets its own step.
+        if (settingsMailbox.acquire()) applySettings(settingsMailbox.readSlot());
+        SimCommand command;
+        while (!config.spawnClick && commands.pop(command)) applyCommand(command, particles, kinematics);
+
+        // Start/stop on toggle edges only, so a failed start is not retried every frame
+        if (config.recordTrajectory != recordRequested) {
+            recordRequested = config.recordTrajectory;
+            if (recordRequested) recorder.start(config.trajectoryPath, fixedDt);
+            else recorder.stop();
+        }
+
+        // 2. Advance one fixed step
+        kinematics.step(config, fixedDt);
+        if (!config.paused) {
+            frame++;
+            rateWindowSteps++;
+            if (recorder.isRecording()) {
+                recorder.capture(frame, kinematics.getLayoutVersion(), [&](ParticleSystem& captured) {
+                    kinematics.copyAsteroids(captured);
+                    captured.planets = particles.planets;
+                });
+            }
+        }
+
+        Clock::time_point now = Clock::now();
+        double windowSeconds = std::chrono::duration<double>(now - rateWindowStart).count();
+        if (windowSeconds >= 0.5) {
+            stepsPerSecond = rateWindowSteps / windowSeconds;
+            rateWindowSteps = 0;
+            rateWindowStart = now;
+        }
+
+        // 3. Publish, unless the UI has not picked up the previous snapshot yet:
+        //    running ahead of the renderer then costs no copies
+        if (!snapshots.pending()) {
+            publishSnapshot(kinematics, particles, stepsPerSecond);
+        }
+
+        // 4. External readers: nothing is copied until one asks for a frame.
+        //    Asteroids are widened straight into the shared slot.
+        if (sharedState.wantsFrame()) {
+            sharedState.publish(particles.planets, kinematics.getParticleCount(), frame, kinematics.getLayoutVersion(),
+                                [&](float* posX, float* posY, float* velX, float* velY) {
+                                    kinematics.copyAsteroids(posX, posY, velX, velY);
+                                });
+        }
+
+        // 5. Pace to simSpeed x real time (0 = as fast as possible).
+        //    While paused, idle at real time instead of spinning.
+        float speed = config.paused ? 1.0f : config.simSpeed;
+        if (speed > 0.0f) {
+            nextStep += std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>(fixedDt / speed));
+            if (now - nextStep > std::chrono::milliseconds(250)) nextStep = now; // Too far behind: don't try to catch up
+            std::this_thread::sleep_until(nextStep);
+        } else {
+            nextStep = now;
+        }
+    }
+
+    // Readers see the segment marked Closed rather than a stalled frame counter
+    sharedState.close();
+}
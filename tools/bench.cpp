@@ -0,0 +1,218 @@
+// Headless batch runner: steps the simulation without SDL/ImGui and reports throughput.
+//
+//   ./bench --particles 200000 --substeps 8 --steps 200 --seed 42 --no-collisions
+//
+// The belt is generated from --seed only, so two runs with the same arguments
+// end in the same state; the printed checksum makes that easy to compare.
+
+#include "kinematics.hpp"
+#include "common.hpp"
+#include "profiler.hpp"
+#include "checkpoint.hpp"
+#include "shared_state.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+
+namespace {
+    void printUsage() {
+        std::cout <<
+            "Usage: bench [options]\n"
+            "  --particles N         Asteroid count (default 100000)\n"
+            "  --substeps N          Substeps per step (default 8)\n"
+            "  --steps N             Steps to run (default 100)\n"
+            "  --seed N              Belt generation seed (default 1)\n"
+            "  --threads N           Worker threads, 0 = all (default 0)\n"
+            "  --dt X                Step length in seconds (default 0.016)\n"
+            "  --no-collisions       Disable collisions\n"
+            "  --serial-collisions   Use the single-threaded collision sweep\n"
+            "  --verlet-skin X       Reuse collision pair lists with this margin\n"
+            "  --no-central-gravity  Disable star gravity\n"
+            "  --self-gravity        Enable Barnes-Hut asteroid self-gravity\n"
+            "  --accretion           Remove asteroids that fall into the star or a planet\n"
+            "  --planets N           Extra planets on circular orbits, as if click-spawned\n"
+            "  --compact             Compact 16-bit storage (with --no-collisions)\n"
+            "  --block-steps         Per-particle power-of-two leapfrog steps\n"
+            "  --accuracy X          Block step accuracy parameter (default 0.025)\n"
+            "  --theta X             Barnes-Hut opening angle\n"
+            "  --damping X           Velocity damping per substep\n"
+            "  --trace FILE          Write the last phase events as Chrome trace JSON\n"
+            "  --load FILE           Start from a checkpoint (its settings replace the\n"
+            "                        simulation options above, except --threads)\n"
+            "  --save FILE           Write a checkpoint after the last step\n"
+            "  --shm NAME            Publish the state to POSIX shared memory when a\n"
+            "                        reader asks (see tools/shm_reader.cpp)\n";
+    }
+
+    // FNV-1a over the raw bits of the particle state
+    uint64_t checksum(const ParticleSystem& particles) {
+        uint64_t hash = 1469598103934665603ULL;
+        for (const std::vector<float>* arr : {&particles.posX, &particles.posY, &particles.velX, &particles.velY}) {
+            for (float f : *arr) {
+                uint32_t bits;
+                std::memcpy(&bits, &f, sizeof(bits));
+                hash = (hash ^ bits) * 1099511628211ULL;
+            }
+        }
+        return hash;
+    }
+
+    // Planets scattered over the belt region with the spawner's mass, radius
+    // and auto-orbit velocity
+    void addPlanets(ParticleSystem& particles, const SimConfig& config, int count) {
+        std::mt19937 rng(config.seed ^ 0x9E3779B9u);
+        std::uniform_real_distribution<float> distance(30.0f, 140.0f);
+        std::uniform_real_distribution<float> angle(0.0f, 2.0f * static_cast<float>(M_PI));
+        for (int i = 0; i < count; ++i) {
+            float r = distance(rng), a = angle(rng);
+            float speed = std::sqrt(config.starMass / r);
+            Planet p;
+            p.x = config.starX + std::cos(a) * r;
+            p.y = config.starY + std::sin(a) * r;
+            p.vx = -std::sin(a) * speed;
+            p.vy = std::cos(a) * speed;
+            p.mass = config.spawnMass;
+            p.radius = config.spawnRadius;
+            p.color = 0xFF0080FF;
+            particles.planets.push_back(p);
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    SimConfig config;
+    config.particleCount = 100000;
+    int steps = 100, extraPlanets = 0;
+    float dt = 0.016f;
+    const char* tracePath = nullptr;
+    const char* loadPath = nullptr;
+    const char* savePath = nullptr;
+    const char* sharedName = nullptr;
+
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (std::strcmp(arg, "--particles") == 0 && hasValue) config.particleCount = std::atoi(argv[++i]);
+        else if (std::strcmp(arg, "--substeps") == 0 && hasValue) config.substeps = std::atoi(argv[++i]);
+        else if (std::strcmp(arg, "--steps") == 0 && hasValue) steps = std::atoi(argv[++i]);
+        else if (std::strcmp(arg, "--seed") == 0 && hasValue) config.seed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        else if (std::strcmp(arg, "--threads") == 0 && hasValue) config.workerThreads = std::atoi(argv[++i]);
+        else if (std::strcmp(arg, "--dt") == 0 && hasValue) dt = std::strtof(argv[++i], nullptr);
+        else if (std::strcmp(arg, "--theta") == 0 && hasValue) config.barnesHutTheta = std::strtof(argv[++i], nullptr);
+        else if (std::strcmp(arg, "--damping") == 0 && hasValue) config.damping = std::strtof(argv[++i], nullptr);
+        else if (std::strcmp(arg, "--trace") == 0 && hasValue) tracePath = argv[++i];
+        else if (std::strcmp(arg, "--load") == 0 && hasValue) loadPath = argv[++i];
+        else if (std::strcmp(arg, "--save") == 0 && hasValue) savePath = argv[++i];
+        else if (std::strcmp(arg, "--shm") == 0 && hasValue) sharedName = argv[++i];
+        else if (std::strcmp(arg, "--no-collisions") == 0) config.enableCollisions = false;
+        else if (std::strcmp(arg, "--serial-collisions") == 0) config.parallelCollisions = false;
+        else if (std::strcmp(arg, "--verlet-skin") == 0 && hasValue) config.verletSkin = std::strtof(argv[++i], nullptr);
+        else if (std::strcmp(arg, "--no-central-gravity") == 0) config.enableCentralGravity = false;
+        else if (std::strcmp(arg, "--self-gravity") == 0) config.enableInterParticleGravity = true;
+        else if (std::strcmp(arg, "--accretion") == 0) config.enableAccretion = true;
+        else if (std::strcmp(arg, "--planets") == 0 && hasValue) extraPlanets = std::atoi(argv[++i]);
+        else if (std::strcmp(arg, "--compact") == 0) config.compactStorage = true;
+        else if (std::strcmp(arg, "--block-steps") == 0) config.blockTimesteps = true;
+        else if (std::strcmp(arg, "--accuracy") == 0 && hasValue) config.timestepAccuracy = std::strtof(argv[++i], nullptr);
+        else {
+            printUsage();
+            return std::strcmp(arg, "--help") == 0 ? 0 : 1;
+        }
+    }
+
+    if (config.particleCount < 0 || config.substeps < 1 || steps < 1) {
+        std::cerr << "[Error] particles must be >= 0, substeps and steps >= 1" << std::endl;
+        return 1;
+    }
+
+    ParticleSystem particles;
+    ParticleKinematics kinematics(particles, config.workerThreads);
+
+    uint64_t startFrame = 0;
+    auto initStart = std::chrono::steady_clock::now();
+    if (loadPath) {
+        MappedCheckpoint checkpoint;
+        if (!checkpoint.open(loadPath)) return 1;
+        int workerThreads = config.workerThreads;
+        checkpoint.restore(particles, config);
+        config.workerThreads = workerThreads;
+        startFrame = checkpoint.frame();
+        kinematics.adoptState(startFrame);
+    } else {
+        kinematics.init(config);
+        addPlanets(particles, config, extraPlanets);
+    }
+    double initSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - initStart).count();
+
+    int initialCount = config.particleCount;
+    SharedStatePublisher shared;
+    if (sharedName && !shared.open(sharedName)) return 1;
+    double publishSeconds = 0.0;
+
+    auto runStart = std::chrono::steady_clock::now();
+    for (int s = 0; s < steps; ++s) {
+        kinematics.step(config, dt);
+        if (shared.wantsFrame()) {
+            auto publishStart = std::chrono::steady_clock::now();
+            shared.publish(particles.planets, kinematics.getParticleCount(), startFrame + s + 1, kinematics.getLayoutVersion(),
+                           [&](float* posX, float* posY, float* velX, float* velY) {
+                               kinematics.copyAsteroids(posX, posY, velX, velY);
+                           });
+            publishSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - publishStart).count();
+        }
+    }
+    double runSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - runStart).count();
+    bool compact = kinematics.isCompact();
+    kinematics.syncParticles();
+
+    const PhaseTimings& t = kinematics.getTimings();
+    double updates = static_cast<double>(config.particleCount) * config.substeps * steps;
+
+    std::printf("particles        %d\n", config.particleCount);
+    std::printf("planets          %zu\n", particles.planets.size());
+    if (config.enableAccretion) std::printf("accreted         %d\n", initialCount - config.particleCount);
+    std::printf("storage          %s\n", compact ? "compact (8 B/particle)" : "float (16 B/particle)");
+    std::printf("substeps         %d\n", config.substeps);
+    std::printf("steps            %d\n", steps);
+    std::printf("seed             %u\n", config.seed);
+    std::printf("init             %.3f s\n", initSeconds);
+    std::printf("run              %.3f s\n", runSeconds);
+    std::printf("steps/sec        %.2f\n", steps / runSeconds);
+    std::printf("updates/sec      %.3e\n", updates / runSeconds);
+    std::printf("force evals      %.3f per particle per step\n",
+                static_cast<double>(kinematics.getForceEvaluations()) / (static_cast<double>(config.particleCount) * steps));
+    std::printf("collisions       %.1f per step\n", static_cast<double>(kinematics.getCollisionCount()) / steps);
+    if (config.verletSkin > 0.0f) {
+        std::printf("pair lists       %.2f builds per step\n", static_cast<double>(kinematics.getPairListBuilds()) / steps);
+    }
+    std::printf("phase forces     %8.3f ms/step\n", t.forces * 1000.0 / steps);
+    std::printf("phase integrate  %8.3f ms/step\n", t.integration * 1000.0 / steps);
+    std::printf("phase collisions %8.3f ms/step\n", t.collisions * 1000.0 / steps);
+    std::printf("phase boundaries %8.3f ms/step\n", t.boundaries * 1000.0 / steps);
+    std::printf("phase reorder    %8.3f ms/step\n", t.reorder * 1000.0 / steps);
+    if (shared.isOpen()) {
+        uint64_t published = shared.framesPublished();
+        std::printf("shared memory    %llu frames, %.3f ms each\n", static_cast<unsigned long long>(published),
+                    published ? publishSeconds * 1000.0 / published : 0.0);
+    }
+    std::printf("checksum         %016llx\n", static_cast<unsigned long long>(checksum(particles)));
+
+    if (savePath) {
+        auto saveStart = std::chrono::steady_clock::now();
+        if (!saveCheckpoint(savePath, particles, config, startFrame + steps)) return 1;
+        double saveSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - saveStart).count();
+        std::printf("save             %.3f s\n", saveSeconds);
+    }
+
+    if (tracePath && !Profiler::instance().dumpChromeTrace(tracePath)) {
+        std::cerr << "[Error] Could not write trace to " << tracePath << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
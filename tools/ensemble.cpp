@@ -0,0 +1,316 @@
+// Parameter sweeps: runs every combination of the values in a sweep spec as
+// independent single-threaded simulations, one per core, and appends one CSV
+// row of end-of-run metrics per configuration.
+//
+//   ./ensemble --spec sweep.txt --out sweep.csv --jobs 8
+//
+// Spec file, one parameter per line, values separated by spaces; a value of
+// the form start:end:count expands to count evenly spaced values (inclusive).
+// '#' starts a comment. Parameters left out keep the SimConfig defaults.
+//
+//   starMass        8000 10000 12000
+//   restitution     0.3:0.9:4
+//   damping         1.0 0.999
+//   collisionRadius 0.2 0.5
+//   seed            1:5:5
+//   particles       20000
+//   steps           600
+//
+// Rows are written as runs finish, so a sweep that is stopped keeps its
+// results; the `run` column gives each configuration's position in the
+// sweep order (last parameter varies fastest).
+
+#include "kinematics.hpp"
+#include "common.hpp"
+#include "profiler.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    void printUsage() {
+        std::cerr <<
+            "Usage: ensemble --spec FILE [options]\n"
+            "  --spec FILE           Sweep specification (see tools/ensemble.cpp)\n"
+            "  --out FILE            CSV output (default ensemble.csv)\n"
+            "  --jobs N              Concurrent runs, 0 = all cores (default 0)\n"
+            "  --dry-run             List the configurations without running them\n";
+    }
+
+    // One configuration of the sweep
+    struct RunSettings {
+        SimConfig config;
+        int steps = 600;
+        float dt = 0.016f;
+    };
+
+    struct Parameter {
+        const char* name;
+        void (*apply)(RunSettings& run, double value);
+    };
+
+    const Parameter PARAMETERS[] = {
+        { "starMass",        [](RunSettings& r, double v) { r.config.starMass = static_cast<float>(v); } },
+        { "restitution",     [](RunSettings& r, double v) { r.config.restitution = static_cast<float>(v); } },
+        { "damping",         [](RunSettings& r, double v) { r.config.damping = static_cast<float>(v); } },
+        { "collisionRadius", [](RunSettings& r, double v) { r.config.collisionRadius = static_cast<float>(v); } },
+        { "seed",            [](RunSettings& r, double v) { r.config.seed = static_cast<uint32_t>(v); } },
+        { "particles",       [](RunSettings& r, double v) { r.config.particleCount = static_cast<int>(v); } },
+        { "substeps",        [](RunSettings& r, double v) { r.config.substeps = static_cast<int>(v); } },
+        { "steps",           [](RunSettings& r, double v) { r.steps = static_cast<int>(v); } },
+        { "dt",              [](RunSettings& r, double v) { r.dt = static_cast<float>(v); } },
+    };
+
+    struct Axis {
+        const Parameter* parameter;
+        std::vector<double> values;
+    };
+
+    const Parameter* findParameter(const std::string& name) {
+        for (const Parameter& p : PARAMETERS) {
+            if (name == p.name) return &p;
+        }
+        return nullptr;
+    }
+
+    // "v" or "start:end:count"
+    bool parseValues(const std::string& token, std::vector<double>& out) {
+        double start, end;
+        int count;
+        char tail;
+        if (std::sscanf(token.c_str(), "%lf:%lf:%d%c", &start, &end, &count, &tail) == 3) {
+            if (count < 1) return false;
+            for (int i = 0; i < count; ++i) {
+                out.push_back(count == 1 ? start : start + (end - start) * i / (count - 1));
+            }
+            return true;
+        }
+        char* parsedEnd = nullptr;
+        double value = std::strtod(token.c_str(), &parsedEnd);
+        if (parsedEnd == token.c_str() || *parsedEnd != '\0') return false;
+        out.push_back(value);
+        return true;
+    }
+
+    bool loadSpec(const char* path, std::vector<Axis>& axes) {
+        std::ifstream file(path);
+        if (!file) {
+            std::cerr << "[Ensemble] Cannot open " << path << std::endl;
+            return false;
+        }
+
+        std::string line;
+        for (int lineNumber = 1; std::getline(file, line); ++lineNumber) {
+            line = line.substr(0, line.find('#'));
+            std::istringstream words(line);
+            std::string name, token;
+            if (!(words >> name)) continue;
+
+            const Parameter* parameter = findParameter(name);
+            if (!parameter) {
+                std::cerr << "[Ensemble] " << path << ":" << lineNumber << ": unknown parameter " << name << std::endl;
+                return false;
+            }
+            Axis axis{ parameter, {} };
+            while (words >> token) {
+                if (!parseValues(token, axis.values)) {
+                    std::cerr << "[Ensemble] " << path << ":" << lineNumber << ": bad value " << token << std::endl;
+                    return false;
+                }
+            }
+            if (axis.values.empty()) {
+                std::cerr << "[Ensemble] " << path << ":" << lineNumber << ": no values for " << name << std::endl;
+                return false;
+            }
+            axes.push_back(axis);
+        }
+        return true;
+    }
+
+    // Configuration `index` of the cartesian product, last axis fastest
+    std::vector<double> combination(const std::vector<Axis>& axes, size_t index) {
+        std::vector<double> values(axes.size());
+        for (size_t a = axes.size(); a-- > 0;) {
+            values[a] = axes[a].values[index % axes[a].values.size()];
+            index /= axes[a].values.size();
+        }
+        return values;
+    }
+
+    struct Metrics {
+        int particles = 0;
+        double kineticEnergy = 0.0;   // Mean 0.5 |v|^2 per asteroid
+        double meanRadius = 0.0;      // Mean distance from the star
+        double beltWidth = 0.0;       // Standard deviation of that distance
+        uint64_t collisions = 0;
+        double seconds = 0.0;
+    };
+
+    Metrics measure(const ParticleSystem& particles, const SimConfig& config) {
+        Metrics m;
+        size_t n = particles.posX.size();
+        m.particles = static_cast<int>(n);
+        if (n == 0) return m;
+
+        double energy = 0.0, sumR = 0.0, sumR2 = 0.0;
+        for (size_t i = 0; i < n; ++i) {
+            double vx = particles.velX[i], vy = particles.velY[i];
+            energy += 0.5 * (vx*vx + vy*vy);
+            double dx = particles.posX[i] - config.starX, dy = particles.posY[i] - config.starY;
+            double r = std::sqrt(dx*dx + dy*dy);
+            sumR += r;
+            sumR2 += r * r;
+        }
+        m.kineticEnergy = energy / n;
+        m.meanRadius = sumR / n;
+        m.beltWidth = std::sqrt(std::max(0.0, sumR2 / n - m.meanRadius * m.meanRadius));
+        return m;
+    }
+
+    Metrics runOne(RunSettings run) {
+        // Parallelism comes from running many configurations at once
+        run.config.workerThreads = 1;
+
+        ParticleSystem particles;
+        ParticleKinematics kinematics(particles, run.config.workerThreads);
+        auto start = std::chrono::steady_clock::now();
+        kinematics.init(run.config);
+        for (int s = 0; s < run.steps; ++s) {
+            kinematics.step(run.config, run.dt);
+        }
+        kinematics.syncParticles();
+
+        Metrics m = measure(particles, run.config);
+        m.collisions = kinematics.getCollisionCount();
+        m.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return m;
+    }
+}
+
+int main(int argc, char** argv) {
+    const char* specPath = nullptr;
+    const char* outPath = "ensemble.csv";
+    int jobs = 0;
+    bool dryRun = false;
+
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (std::strcmp(arg, "--spec") == 0 && hasValue) specPath = argv[++i];
+        else if (std::strcmp(arg, "--out") == 0 && hasValue) outPath = argv[++i];
+        else if (std::strcmp(arg, "--jobs") == 0 && hasValue) jobs = std::atoi(argv[++i]);
+        else if (std::strcmp(arg, "--dry-run") == 0) dryRun = true;
+        else {
+            printUsage();
+            return std::strcmp(arg, "--help") == 0 ? 0 : 1;
+        }
+    }
+    if (!specPath) {
+        printUsage();
+        return 1;
+    }
+
+    std::vector<Axis> axes;
+    if (!loadSpec(specPath, axes)) return 1;
+
+    size_t total = 1;
+    for (const Axis& axis : axes) total *= axis.values.size();
+
+    std::vector<RunSettings> runs(total);
+    for (size_t r = 0; r < total; ++r) {
+        std::vector<double> values = combination(axes, r);
+        for (size_t a = 0; a < axes.size(); ++a) axes[a].parameter->apply(runs[r], values[a]);
+
+        const RunSettings& run = runs[r];
+        if (run.config.particleCount < 0 || run.config.substeps < 1 || run.steps < 1) {
+            std::cerr << "[Error] run " << r << ": particles must be >= 0, substeps and steps >= 1" << std::endl;
+            return 1;
+        }
+    }
+
+    if (jobs <= 0) jobs = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    jobs = static_cast<int>(std::min<size_t>(jobs, total));
+    std::cout << "[Ensemble] " << total << " configurations, " << jobs << " concurrent" << std::endl;
+
+    // Header: run index, every SimConfig field the spec can set, then metrics
+    std::string header = "run";
+    for (const Parameter& p : PARAMETERS) header += std::string(",") + p.name;
+    header += ",final_particles,kinetic_energy,mean_radius,belt_width,collisions,collisions_per_step,seconds";
+
+    if (dryRun) {
+        std::cout << header.substr(0, header.find(",final_particles")) << std::endl;
+        for (size_t r = 0; r < total; ++r) {
+            const RunSettings& run = runs[r];
+            std::printf("%zu,%g,%g,%g,%g,%u,%d,%d,%d,%g\n", r, run.config.starMass, run.config.restitution,
+                        run.config.damping, run.config.collisionRadius, run.config.seed,
+                        run.config.particleCount, run.config.substeps, run.steps, run.dt);
+        }
+        return 0;
+    }
+
+    FILE* csv = std::fopen(outPath, "w");
+    if (!csv) {
+        std::cerr << "[Error] Cannot write " << outPath << std::endl;
+        return 1;
+    }
+    std::fprintf(csv, "%s\n", header.c_str());
+    std::fflush(csv);
+
+    // Concurrent runs would all record the same phases, and the profiler
+    // expects one thread per phase
+    Profiler::instance().setEnabled(false);
+
+    // The kinematics log one line per instance; keep them out of the progress output
+    std::streambuf* console = std::cout.rdbuf(nullptr);
+
+    std::atomic<size_t> next{0};
+    std::mutex outputMutex;
+    size_t finished = 0;
+    auto sweepStart = std::chrono::steady_clock::now();
+
+    auto worker = [&]() {
+        for (size_t r = next.fetch_add(1); r < total; r = next.fetch_add(1)) {
+            const RunSettings& run = runs[r];
+            Metrics m = runOne(run);
+
+            std::lock_guard<std::mutex> lock(outputMutex);
+            std::fprintf(csv, "%zu,%g,%g,%g,%g,%u,%d,%d,%d,%g,%d,%.6g,%.6g,%.6g,%llu,%.3f,%.3f\n",
+                         r, run.config.starMass, run.config.restitution, run.config.damping,
+                         run.config.collisionRadius, run.config.seed, run.config.particleCount,
+                         run.config.substeps, run.steps, run.dt,
+                         m.particles, m.kineticEnergy, m.meanRadius, m.beltWidth,
+                         static_cast<unsigned long long>(m.collisions),
+                         static_cast<double>(m.collisions) / run.steps, m.seconds);
+            std::fflush(csv);
+
+            finished++;
+            double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - sweepStart).count();
+            double remaining = elapsed / finished * (total - finished);
+            std::fprintf(stderr, "[Ensemble] %zu/%zu done (run %zu, %.1f s), about %.0f s left\n",
+                         finished, total, r, m.seconds, remaining);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int t = 1; t < jobs; ++t) threads.emplace_back(worker);
+    worker();
+    for (std::thread& t : threads) t.join();
+
+    std::cout.rdbuf(console);
+    std::fclose(csv);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - sweepStart).count();
+    std::cout << "[Ensemble] Wrote " << total << " rows to " << outPath << " in " << seconds << " s" << std::endl;
+    return 0;
+}
@@ -0,0 +1,286 @@
+// Offline renderer: steps the simulation at a fixed dt, rasterizes every step
+// into an off-screen buffer and encodes frames on a pool of threads.
+//
+//   ./export --particles 200000 --frames 600 --width 2160 --height 2160 --out - | ffmpeg -i - out.mp4
+//   ./export --format png --out frames/frame_%05d.png
+//
+// Frames travel to the encoders through a bounded queue, so the simulation
+// runs at most FRAMES_IN_FLIGHT frames ahead and memory stays fixed.
+
+#include "kinematics.hpp"
+#include "rasterizer.hpp"
+#include "image_encoder.hpp"
+#include "checkpoint.hpp"
+#include "common.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    void printUsage() {
+        std::cerr <<
+            "Usage: export [options]\n"
+            "  --particles N         Asteroid count (default 100000)\n"
+            "  --frames N            Frames to render (default 600)\n"
+            "  --substeps N          Substeps per frame (default 8)\n"
+            "  --dt X                Simulated seconds per frame (default 0.016)\n"
+            "  --seed N              Belt generation seed (default 1)\n"
+            "  --load FILE           Start from a checkpoint instead of a new belt\n"
+            "  --width N, --height N Frame size (default 1024x1024)\n"
+            "  --fps N               Frame rate written to the Y4M header (default 60)\n"
+            "  --format y4m|png      Output format (default y4m)\n"
+            "  --out PATH            Y4M file or - for stdout (default -);\n"
+            "                        PNG printf pattern (default frame_%05d.png)\n"
+            "  --encoders N          Encoder threads, 0 = all (default 0)\n"
+            "  --threads N           Simulation worker threads, 0 = all (default 0)\n"
+            "  --no-collisions       Disable collisions\n"
+            "  --self-gravity        Enable Barnes-Hut asteroid self-gravity\n"
+            "  --compact             Compact 16-bit storage (with --no-collisions)\n";
+    }
+
+    // The PNG pattern is handed to snprintf: allow exactly one %d (with
+    // optional 0 flag and width) and literal %%, nothing else
+    bool isFramePattern(const char* pattern) {
+        int conversions = 0;
+        for (const char* c = pattern; *c; ++c) {
+            if (*c != '%') continue;
+            if (c[1] == '%') { ++c; continue; }
+            ++c;
+            if (*c == '0') ++c;
+            while (*c >= '0' && *c <= '9') ++c;
+            if (*c != 'd') return false;
+            conversions++;
+        }
+        return conversions == 1;
+    }
+
+    // Minimal blocking FIFO for frame slot indices
+    class SlotQueue {
+        public:
+            void push(int slot) {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    items.push_back(slot);
+                }
+                ready.notify_one();
+            }
+
+            // Returns -1 once closed and drained
+            int pop() {
+                std::unique_lock<std::mutex> lock(mutex);
+                ready.wait(lock, [this] { return !items.empty() || closed; });
+                if (items.empty()) return -1;
+                int slot = items.front();
+                items.pop_front();
+                return slot;
+            }
+
+            void close() {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    closed = true;
+                }
+                ready.notify_all();
+            }
+
+        private:
+            std::mutex mutex;
+            std::condition_variable ready;
+            std::deque<int> items;
+            bool closed = false;
+    };
+
+    struct Frame {
+        std::vector<uint32_t> pixels;
+        int index = 0;
+    };
+
+    // Y4M is one stream: encoders convert in parallel, then append in frame order
+    class OrderedWriter {
+        public:
+            explicit OrderedWriter(FILE* out) : out(out) {}
+
+            bool write(int index, const std::vector<uint8_t>& yuv) {
+                std::unique_lock<std::mutex> lock(mutex);
+                turn.wait(lock, [&] { return nextIndex == index; });
+                bool ok = writeY4mFrame(out, yuv);
+                nextIndex++;
+                turn.notify_all();
+                return ok;
+            }
+
+        private:
+            FILE* out;
+            std::mutex mutex;
+            std::condition_variable turn;
+            int nextIndex = 0;
+    };
+}
+
+int main(int argc, char** argv) {
+    SimConfig config;
+    config.particleCount = 100000;
+    int frames = 600;
+    float dt = 0.016f;
+    int width = 1024, height = 1024, fps = 60, encoderCount = 0;
+    bool png = false;
+    const char* outPath = nullptr;
+    const char* loadPath = nullptr;
+
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (std::strcmp(arg, "--particles") == 0 && hasValue) config.particleCount = std::atoi(argv[++i]);
+        else if (std::strcmp(arg, "--frames") == 0 && hasValue) frames = std::atoi(argv[++i]);
+        else if (std::strcmp(arg, "--substeps") == 0 && hasValue) config.substeps = std::atoi(argv[++i]);
+        else if (std::strcmp(arg, "--dt") == 0 && hasValue) dt = std::strtof(argv[++i], nullptr);
+        else if (std::strcmp(arg, "--seed") == 0 && hasValue) config.seed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        else if (std::strcmp(arg, "--load") == 0 && hasValue) loadPath = argv[++i];
+        else if (std::strcmp(arg, "--width") == 0 && hasValue) width = std::atoi(argv[++i]);
+        else if (std::strcmp(arg, "--height") == 0 && hasValue) height = std::atoi(argv[++i]);
+        else if (std::strcmp(arg, "--fps") == 0 && hasValue) fps = std::atoi(argv[++i]);
+        else if (std::strcmp(arg, "--format") == 0 && hasValue) png = std::strcmp(argv[++i], "png") == 0;
+        else if (std::strcmp(arg, "--out") == 0 && hasValue) outPath = argv[++i];
+        else if (std::strcmp(arg, "--encoders") == 0 && hasValue) encoderCount = std::atoi(argv[++i]);
+        else if (std::strcmp(arg, "--threads") == 0 && hasValue) config.workerThreads = std::atoi(argv[++i]);
+        else if (std::strcmp(arg, "--no-collisions") == 0) config.enableCollisions = false;
+        else if (std::strcmp(arg, "--self-gravity") == 0) config.enableInterParticleGravity = true;
+        else if (std::strcmp(arg, "--compact") == 0) config.compactStorage = true;
+        else {
+            printUsage();
+            return std::strcmp(arg, "--help") == 0 ? 0 : 1;
+        }
+    }
+
+    if (frames < 1 || config.substeps < 1 || width < 2 || height < 2 || fps < 1) {
+        std::cerr << "[Error] frames, substeps, fps must be >= 1 and the frame at least 2x2" << std::endl;
+        return 1;
+    }
+    if (!png && (width % 2 || height % 2)) {
+        std::cerr << "[Error] Y4M 4:2:0 needs an even width and height" << std::endl;
+        return 1;
+    }
+    if (!outPath) outPath = png ? "frame_%05d.png" : "-";
+    if (png && !isFramePattern(outPath)) {
+        std::cerr << "[Error] --out for PNG needs exactly one %d (e.g. frame_%05d.png); write % as %%" << std::endl;
+        return 1;
+    }
+
+    // Frames may go to stdout: keep every log line on stderr
+    std::cout.rdbuf(std::cerr.rdbuf());
+
+    FILE* y4m = nullptr;
+    if (!png) {
+        y4m = std::strcmp(outPath, "-") == 0 ? stdout : std::fopen(outPath, "wb");
+        if (!y4m || !writeY4mHeader(y4m, width, height, fps)) {
+            std::cerr << "[Error] Cannot write " << outPath << std::endl;
+            return 1;
+        }
+    }
+
+    // 1. Simulation
+    ParticleSystem particles;
+    ParticleKinematics kinematics(particles, config.workerThreads);
+    if (loadPath) {
+        MappedCheckpoint checkpoint;
+        if (!checkpoint.open(loadPath)) return 1;
+        int workerThreads = config.workerThreads;
+        checkpoint.restore(particles, config);
+        config.workerThreads = workerThreads;
+        kinematics.adoptState(checkpoint.frame());
+    } else {
+        kinematics.init(config);
+    }
+
+    // 2. Encoder pool fed through a bounded set of frame slots
+    if (encoderCount <= 0) encoderCount = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    const int FRAMES_IN_FLIGHT = encoderCount * 2;
+
+    std::vector<Frame> slots(FRAMES_IN_FLIGHT);
+    SlotQueue freeSlots, encodeQueue;
+    for (int s = 0; s < FRAMES_IN_FLIGHT; ++s) {
+        slots[s].pixels.resize(static_cast<size_t>(width) * height);
+        freeSlots.push(s);
+    }
+
+    OrderedWriter y4mWriter(y4m);
+    std::atomic<bool> failed{false};
+
+    std::vector<std::thread> encoders;
+    for (int e = 0; e < encoderCount; ++e) {
+        encoders.emplace_back([&] {
+            std::vector<uint8_t> encoded;
+            std::vector<char> path(std::strlen(outPath) + 32);
+            for (int slot = encodeQueue.pop(); slot >= 0; slot = encodeQueue.pop()) {
+                const Frame& frame = slots[slot];
+                bool ok;
+                if (png) {
+                    encodePng(frame.pixels.data(), width, height, encoded);
+                    std::snprintf(path.data(), path.size(), outPath, frame.index);
+                    ok = writeFile(path.data(), encoded);
+                } else {
+                    convertToYuv420(frame.pixels.data(), width, height, encoded);
+                    ok = y4mWriter.write(frame.index, encoded);
+                }
+                if (!ok && !failed.exchange(true)) {
+                    std::cerr << "[Error] Failed to write frame " << frame.index << std::endl;
+                }
+                freeSlots.push(slot);
+            }
+        });
+    }
+
+    // 3. Step, rasterize, hand off
+    Rasterizer rasterizer(width, height, config.workerThreads);
+    ParticleSystem frameParticles;    // Compact runs are widened into this, never into a mirror
+    double simSeconds = 0.0, rasterSeconds = 0.0, waitSeconds = 0.0;
+    auto start = std::chrono::steady_clock::now();
+
+    for (int f = 0; f < frames && !failed; ++f) {
+        auto t0 = std::chrono::steady_clock::now();
+        kinematics.step(config, dt);
+        if (kinematics.isCompact()) {
+            kinematics.copyAsteroids(frameParticles);
+            frameParticles.planets = particles.planets;
+        }
+        const ParticleSystem& drawn = kinematics.isCompact() ? frameParticles : particles;
+        auto t1 = std::chrono::steady_clock::now();
+        int slot = freeSlots.pop();
+        auto t2 = std::chrono::steady_clock::now();
+
+        rasterizer.draw(drawn, slots[slot].pixels.data(), width * static_cast<int>(sizeof(uint32_t)));
+        slots[slot].index = f;
+        encodeQueue.push(slot);
+        auto t3 = std::chrono::steady_clock::now();
+
+        simSeconds += std::chrono::duration<double>(t1 - t0).count();
+        waitSeconds += std::chrono::duration<double>(t2 - t1).count();
+        rasterSeconds += std::chrono::duration<double>(t3 - t2).count();
+        if ((f + 1) % 100 == 0) std::cerr << "[Export] " << f + 1 << "/" << frames << " frames" << std::endl;
+    }
+
+    encodeQueue.close();
+    for (std::thread& t : encoders) t.join();
+    if (y4m && y4m != stdout) std::fclose(y4m);
+    else if (y4m) std::fflush(y4m);
+
+    double total = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::fprintf(stderr, "frames           %d (%dx%d, %s, %d encoders)\n", frames, width, height, png ? "png" : "y4m", encoderCount);
+    std::fprintf(stderr, "total            %.3f s (%.2f frames/sec)\n", total, frames / total);
+    std::fprintf(stderr, "simulate         %8.3f ms/frame\n", simSeconds * 1000.0 / frames);
+    std::fprintf(stderr, "rasterize        %8.3f ms/frame\n", rasterSeconds * 1000.0 / frames);
+    std::fprintf(stderr, "encoder wait     %8.3f ms/frame\n", waitSeconds * 1000.0 / frames);
+
+    return failed ? 1 : 0;
+}
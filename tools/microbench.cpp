@@ -0,0 +1,416 @@
+// Kernel micro-benchmarks: times each kinematics phase and the frame fill on
+// its own, over synthetic particle distributions and a sweep of counts, and
+// checks the results against a stored baseline.
+//
+//   ./microbench --save baseline.json                  record a baseline
+//   ./microbench --baseline baseline.json --threshold 10
+//
+// The second form exits with status 1 when any kernel is more than 10%
+// slower per particle than in the baseline. Kernels:
+//
+//   forces         star and planet gravity kick (runPhase Forces)
+//   integrate      drift and damping (runPhase Integration)
+//   collisions     hash build and pair resolution (runPhase Collisions)
+//   boundaries     wall reflection (runPhase Boundaries)
+//   update_buffer  reference single-threaded frame fill
+//   rasterizer     parallel tiled frame fill
+//
+// Distributions (all generated from --seed):
+//
+//   uniform   bodies spread over the whole box
+//   belt      the simulation's own asteroid belt and three planets
+//   clumps    64 Gaussian clumps, dense collision cells
+//   planets   the belt plus 256 extra planets
+//
+// Every repetition starts from the same state, and the best repetition is
+// reported. bytes/particle counts the particle array bytes a kernel reads
+// plus writes (and the frame buffer for the raster kernels), so
+// bytes/particle / ns/particle is the achieved bandwidth.
+
+#include "kinematics.hpp"
+#include "rasterizer.hpp"
+#include "common.hpp"
+#include "philox.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+    void printUsage() {
+        std::cerr <<
+            "Usage: microbench [options]\n"
+            "  --counts LIST         Particle counts (default 1000,10000,100000,1000000,10000000)\n"
+            "  --kernels LIST        Subset of forces,integrate,collisions,boundaries,\n"
+            "                        update_buffer,rasterizer (default all)\n"
+            "  --distributions LIST  Subset of uniform,belt,clumps,planets (default all)\n"
+            "  --min-time X          Seconds of repetitions per measurement (default 0.2)\n"
+            "  --threads N           Worker threads, 0 = all (default 0)\n"
+            "  --seed N              Distribution seed (default 1)\n"
+            "  --baseline FILE       Compare against a JSON baseline\n"
+            "  --threshold PCT       Allowed slowdown against the baseline (default 10)\n"
+            "  --save FILE           Write the results as a JSON baseline\n";
+    }
+
+    constexpr int SCREEN_SIZE = 1024;      // Same frame as the windowed frontend
+    constexpr float BENCH_DT = 0.002f;     // One substep of the default 0.016 s step
+    constexpr int EXTRA_PLANETS = 256;
+    constexpr int CLUMPS = 64;
+    constexpr float CLUMP_SIGMA = 10.0f;
+
+    struct Kernel {
+        const char* name;
+        ProfilePhase phase;     // Kinematics phase, or Rasterize for the frame fills
+        int bytesPerParticle;
+    };
+
+    const Kernel KERNELS[] = {
+        { "forces",        ProfilePhase::Forces,      24 },   // Read pos, read and write vel
+        { "integrate",     ProfilePhase::Integration, 32 },   // Read and write pos and vel
+        { "collisions",    ProfilePhase::Collisions,  32 },   // Read pos for the hash, then pos and vel of each pair
+        { "boundaries",    ProfilePhase::Boundaries,  32 },   // Read and write pos and vel
+        { "update_buffer", ProfilePhase::Rasterize,   16 },   // Read pos and vel, plus the frame
+        { "rasterizer",    ProfilePhase::Rasterize,   16 },
+    };
+
+    const char* const DISTRIBUTIONS[] = { "uniform", "belt", "clumps", "planets" };
+
+    struct Result {
+        std::string kernel;
+        std::string distribution;
+        long long particles = 0;
+        double nsPerParticle = 0.0;
+        double bytesPerParticle = 0.0;
+    };
+
+    std::vector<std::string> splitList(const char* list) {
+        std::vector<std::string> items;
+        std::stringstream stream(list);
+        std::string item;
+        while (std::getline(stream, item, ',')) {
+            if (!item.empty()) items.push_back(item);
+        }
+        return items;
+    }
+
+    bool contains(const std::vector<std::string>& list, const char* name) {
+        return std::find(list.begin(), list.end(), name) != list.end();
+    }
+
+    // Fills `particles` with distribution `name` and hands it to `kinematics`
+    void generate(const std::string& name, int count, const SimConfig& config,
+                  ParticleSystem& particles, ParticleKinematics& kinematics) {
+        SimConfig beltConfig = config;
+        beltConfig.particleCount = count;
+
+        if (name == "belt" || name == "planets") {
+            kinematics.init(beltConfig);
+            if (name == "planets") {
+                for (int i = 0; i < EXTRA_PLANETS; ++i) {
+                    Philox4x32 r = Philox4x32::generate(i, 0, 1, 0, config.seed, 0x9E3779B9u);
+                    float dist = 30.0f + 110.0f * r.uniform(0);
+                    float angle = 2.0f * static_cast<float>(M_PI) * r.uniform(1);
+                    float speed = std::sqrt(config.starMass / dist);
+                    Planet p;
+                    p.x = config.starX + std::cos(angle) * dist;
+                    p.y = config.starY + std::sin(angle) * dist;
+                    p.vx = -std::sin(angle) * speed;
+                    p.vy = std::cos(angle) * speed;
+                    p.mass = config.spawnMass;
+                    p.radius = config.spawnRadius;
+                    p.color = 0xFF0080FF;
+                    particles.planets.push_back(p);
+                }
+            }
+            return;
+        }
+
+        particles.posX.resize(count);
+        particles.posY.resize(count);
+        particles.velX.resize(count);
+        particles.velY.resize(count);
+        particles.planets.clear();
+
+        const float margin = config.collisionRadius;
+        for (int i = 0; i < count; ++i) {
+            Philox4x32 r = Philox4x32::generate(i, 0, 0, 0, config.seed, 0x5EEDB1A5u);
+            float x, y;
+            if (name == "uniform") {
+                x = margin + (SIM_WIDTH - 2.0f * margin) * r.uniform(0);
+                y = margin + (SIM_HEIGHT - 2.0f * margin) * r.uniform(1);
+            } else {
+                // Clump centers come from their own counters; Box-Muller for the offset
+                Philox4x32 c = Philox4x32::generate(i % CLUMPS, 0, 2, 0, config.seed, 0x5EEDB1A5u);
+                float cx = 30.0f + (SIM_WIDTH - 60.0f) * c.uniform(0);
+                float cy = 30.0f + (SIM_HEIGHT - 60.0f) * c.uniform(1);
+                float radius = CLUMP_SIGMA * std::sqrt(-2.0f * std::log(1.0f - r.uniform(0)));
+                float angle = 2.0f * static_cast<float>(M_PI) * r.uniform(1);
+                x = std::min(std::max(cx + radius * std::cos(angle), margin), SIM_WIDTH - margin);
+                y = std::min(std::max(cy + radius * std::sin(angle), margin), SIM_HEIGHT - margin);
+            }
+            particles.posX[i] = x;
+            particles.posY[i] = y;
+            particles.velX[i] = 4.0f * r.uniform(2) - 2.0f;
+            particles.velY[i] = 4.0f * r.uniform(3) - 2.0f;
+        }
+        kinematics.adoptState(0);
+    }
+
+    // Best seconds per call over repetitions totalling at least minTime;
+    // `restore` runs untimed before each call
+    template <typename Restore, typename Run>
+    double timeBest(double minTime, Restore&& restore, Run&& run) {
+        restore();
+        run();  // Warm-up: scratch buffers, hash tables, page faults
+
+        double best = 1e30, total = 0.0;
+        int reps = 0;
+        // At least three repetitions, unless a single one already outlasts minTime
+        while (total < minTime || (reps < 3 && best < minTime)) {
+            restore();
+            auto start = std::chrono::steady_clock::now();
+            run();
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            best = std::min(best, seconds);
+            total += seconds;
+            reps++;
+        }
+        return best;
+    }
+
+    // --- Baseline File ---
+    // {"threads": N, "results": [{"kernel": "...", "distribution": "...",
+    //   "particles": N, "ns_per_particle": X, "bytes_per_particle": X}, ...]}
+
+    bool saveBaseline(const char* path, const std::vector<Result>& results, int threads) {
+        FILE* file = std::fopen(path, "w");
+        if (!file) {
+            std::cerr << "[Error] Cannot write " << path << std::endl;
+            return false;
+        }
+        std::fprintf(file, "{\n  \"threads\": %d,\n  \"results\": [\n", threads);
+        for (size_t i = 0; i < results.size(); ++i) {
+            const Result& r = results[i];
+            std::fprintf(file, "    {\"kernel\": \"%s\", \"distribution\": \"%s\", \"particles\": %lld, "
+                               "\"ns_per_particle\": %.6g, \"bytes_per_particle\": %.6g}%s\n",
+                         r.kernel.c_str(), r.distribution.c_str(), r.particles,
+                         r.nsPerParticle, r.bytesPerParticle, i + 1 < results.size() ? "," : "");
+        }
+        std::fprintf(file, "  ]\n}\n");
+        return std::fclose(file) == 0;
+    }
+
+    // Value of "key" in one flat JSON object, as text without quotes
+    bool jsonField(const std::string& object, const char* key, std::string& value) {
+        std::string pattern = std::string("\"") + key + "\"";
+        size_t at = object.find(pattern);
+        if (at == std::string::npos) return false;
+        at = object.find(':', at + pattern.size());
+        if (at == std::string::npos) return false;
+        at = object.find_first_not_of(" \t\r\n", at + 1);
+        if (at == std::string::npos) return false;
+        if (object[at] == '"') {
+            size_t end = object.find('"', at + 1);
+            if (end == std::string::npos) return false;
+            value = object.substr(at + 1, end - at - 1);
+        } else {
+            size_t end = object.find_first_of(",}", at);
+            value = object.substr(at, end - at);
+        }
+        return true;
+    }
+
+    // Reads files written by saveBaseline() (any whitespace layout)
+    bool loadBaseline(const char* path, std::vector<Result>& results, int& threads) {
+        std::ifstream file(path);
+        if (!file) {
+            std::cerr << "[Error] Cannot open " << path << std::endl;
+            return false;
+        }
+        std::stringstream buffer;
+        buffer << file.rdbuf();
+        std::string text = buffer.str();
+
+        std::string value;
+        threads = jsonField(text, "threads", value) ? std::atoi(value.c_str()) : 0;
+
+        size_t list = text.find("\"results\"");
+        if (list == std::string::npos) {
+            std::cerr << "[Error] " << path << ": no \"results\" list" << std::endl;
+            return false;
+        }
+        for (size_t open = text.find('{', list); open != std::string::npos; open = text.find('{', open + 1)) {
+            size_t close = text.find('}', open);
+            if (close == std::string::npos) break;
+            std::string object = text.substr(open, close - open + 1);
+
+            Result r;
+            std::string particles, ns, bytes;
+            if (!jsonField(object, "kernel", r.kernel) || !jsonField(object, "distribution", r.distribution) ||
+                !jsonField(object, "particles", particles) || !jsonField(object, "ns_per_particle", ns)) {
+                std::cerr << "[Error] " << path << ": malformed entry " << object << std::endl;
+                return false;
+            }
+            r.particles = std::atoll(particles.c_str());
+            r.nsPerParticle = std::atof(ns.c_str());
+            if (jsonField(object, "bytes_per_particle", bytes)) r.bytesPerParticle = std::atof(bytes.c_str());
+            results.push_back(r);
+        }
+        return true;
+    }
+
+    const Result* findResult(const std::vector<Result>& results, const Result& key) {
+        for (const Result& r : results) {
+            if (r.kernel == key.kernel && r.distribution == key.distribution && r.particles == key.particles) return &r;
+        }
+        return nullptr;
+    }
+}
+
+int main(int argc, char** argv) {
+    std::vector<std::string> counts = { "1000", "10000", "100000", "1000000", "10000000" };
+    std::vector<std::string> kernels, distributions;
+    for (const Kernel& k : KERNELS) kernels.push_back(k.name);
+    for (const char* d : DISTRIBUTIONS) distributions.push_back(d);
+    double minTime = 0.2, threshold = 10.0;
+    const char* baselinePath = nullptr;
+    const char* savePath = nullptr;
+    SimConfig config;
+
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (std::strcmp(arg, "--counts") == 0 && hasValue) counts = splitList(argv[++i]);
+        else if (std::strcmp(arg, "--kernels") == 0 && hasValue) kernels = splitList(argv[++i]);
+        else if (std::strcmp(arg, "--distributions") == 0 && hasValue) distributions = splitList(argv[++i]);
+        else if (std::strcmp(arg, "--min-time") == 0 && hasValue) minTime = std::strtod(argv[++i], nullptr);
+        else if (std::strcmp(arg, "--threads") == 0 && hasValue) config.workerThreads = std::atoi(argv[++i]);
+        else if (std::strcmp(arg, "--seed") == 0 && hasValue) config.seed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        else if (std::strcmp(arg, "--baseline") == 0 && hasValue) baselinePath = argv[++i];
+        else if (std::strcmp(arg, "--threshold") == 0 && hasValue) threshold = std::strtod(argv[++i], nullptr);
+        else if (std::strcmp(arg, "--save") == 0 && hasValue) savePath = argv[++i];
+        else {
+            printUsage();
+            return std::strcmp(arg, "--help") == 0 ? 0 : 1;
+        }
+    }
+
+    for (const std::string& name : kernels) {
+        bool known = false;
+        for (const Kernel& k : KERNELS) known |= name == k.name;
+        if (!known) {
+            std::cerr << "[Error] Unknown kernel " << name << std::endl;
+            return 1;
+        }
+    }
+    for (const std::string& name : distributions) {
+        bool known = false;
+        for (const char* d : DISTRIBUTIONS) known |= name == d;
+        if (!known) {
+            std::cerr << "[Error] Unknown distribution " << name << std::endl;
+            return 1;
+        }
+    }
+    std::vector<int> particleCounts;
+    for (const std::string& c : counts) {
+        int n = std::atoi(c.c_str());
+        if (n < 1) {
+            std::cerr << "[Error] Bad particle count " << c << std::endl;
+            return 1;
+        }
+        particleCounts.push_back(n);
+    }
+
+    std::vector<Result> baseline;
+    int baselineThreads = 0;
+    if (baselinePath && !loadBaseline(baselinePath, baseline, baselineThreads)) return 1;
+    if (baselinePath && baselineThreads != config.workerThreads) {
+        std::cerr << "[Warning] Baseline was recorded with --threads " << baselineThreads
+                  << ", this run uses " << config.workerThreads << std::endl;
+    }
+
+    // The kinematics log init and resize messages; keep them out of the table
+    std::streambuf* console = std::cout.rdbuf(nullptr);
+    std::printf("%-14s %-9s %10s %12s %10s %8s %12s %8s\n",
+                "kernel", "dist", "particles", "ns/particle", "B/particle", "GB/s", "baseline", "change");
+
+    std::vector<Result> results;
+    int regressions = 0;
+    Rasterizer rasterizer(SCREEN_SIZE, SCREEN_SIZE, config.workerThreads);
+    std::vector<uint32_t> frame(static_cast<size_t>(SCREEN_SIZE) * SCREEN_SIZE);
+    std::vector<uint32_t> rasterFrame(frame.size());
+
+    for (const std::string& distribution : distributions) {
+        for (int count : particleCounts) {
+            ParticleSystem particles;
+            ParticleKinematics kinematics(particles, config.workerThreads);
+            generate(distribution, count, config, particles, kinematics);
+            const ParticleSystem initial = particles;
+
+            auto restore = [&]() {
+                std::copy(initial.posX.begin(), initial.posX.end(), particles.posX.begin());
+                std::copy(initial.posY.begin(), initial.posY.end(), particles.posY.begin());
+                std::copy(initial.velX.begin(), initial.velX.end(), particles.velX.begin());
+                std::copy(initial.velY.begin(), initial.velY.end(), particles.velY.begin());
+                particles.planets = initial.planets;
+            };
+
+            for (const Kernel& kernel : KERNELS) {
+                if (!contains(kernels, kernel.name)) continue;
+
+                double seconds;
+                double frameBytes = 0.0;
+                if (std::strcmp(kernel.name, "update_buffer") == 0) {
+                    seconds = timeBest(minTime, [] {}, [&] { updateBuffer(frame, particles, SCREEN_SIZE, SCREEN_SIZE); });
+                    frameBytes = static_cast<double>(frame.size()) * sizeof(uint32_t);
+                } else if (std::strcmp(kernel.name, "rasterizer") == 0) {
+                    seconds = timeBest(minTime, [] {},
+                                       [&] { rasterizer.draw(particles, rasterFrame.data(), SCREEN_SIZE * sizeof(uint32_t)); });
+                    frameBytes = static_cast<double>(rasterFrame.size()) * sizeof(uint32_t);
+                } else {
+                    seconds = timeBest(minTime, restore, [&] { kinematics.runPhase(config, kernel.phase, BENCH_DT); });
+                }
+
+                Result r;
+                r.kernel = kernel.name;
+                r.distribution = distribution;
+                r.particles = count;
+                r.nsPerParticle = seconds * 1e9 / count;
+                r.bytesPerParticle = kernel.bytesPerParticle + frameBytes / count;
+                results.push_back(r);
+
+                std::printf("%-14s %-9s %10d %12.3f %10.1f %8.2f", kernel.name, distribution.c_str(), count,
+                            r.nsPerParticle, r.bytesPerParticle, r.bytesPerParticle / r.nsPerParticle);
+                const Result* base = findResult(baseline, r);
+                if (base && base->nsPerParticle > 0.0) {
+                    double change = (r.nsPerParticle / base->nsPerParticle - 1.0) * 100.0;
+                    bool regressed = change > threshold;
+                    regressions += regressed;
+                    std::printf(" %12.3f %+7.1f%%%s\n", base->nsPerParticle, change, regressed ? "  REGRESSION" : "");
+                } else {
+                    std::printf(" %12s %8s\n", "-", baselinePath ? "new" : "");
+                }
+                std::fflush(stdout);
+            }
+        }
+    }
+    std::cout.rdbuf(console);
+
+    if (savePath) {
+        if (!saveBaseline(savePath, results, config.workerThreads)) return 1;
+        std::cout << "[Microbench] Wrote " << results.size() << " results to " << savePath << std::endl;
+    }
+    if (baselinePath) {
+        std::cout << "[Microbench] " << regressions << " of " << results.size()
+                  << " measurements more than " << threshold << "% slower than " << baselinePath << std::endl;
+    }
+    return regressions > 0 ? 1 : 0;
+}
@@ -0,0 +1,146 @@
+// Reference consumer for the shared-memory state export: attaches to a running
+// simulation, asks for frames and summarises each one read in place.
+//
+//   ./bench --particles 1000000 --steps 100000 --shm /particles &
+//   ./shm_reader --name /particles --frames 20 --interval 0.25
+//
+// It uses the protocol documented in shared/include/shared_state.hpp: bump the
+// request counter, wait for the published count to move, read the newest slot
+// without copying and check its sequence afterwards. A torn read (the writer
+// lapped us) is simply retried. A replaced segment is reopened; a closed one
+// (the writer exited) ends the run.
+
+#include "shared_state.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+namespace {
+    void printUsage() {
+        std::cerr <<
+            "Usage: shm_reader [options]\n"
+            "  --name NAME           Shared memory segment (default /particles)\n"
+            "  --frames N            Frames to read, 0 = until the writer exits (default 10)\n"
+            "  --interval X          Seconds between requests (default 0.5)\n"
+            "  --timeout X           Seconds to wait for the writer (default 10)\n";
+    }
+
+    using Clock = std::chrono::steady_clock;
+
+    struct FrameSummary {
+        double centerX = 0.0, centerY = 0.0;   // Mean asteroid position
+        double rmsSpeed = 0.0;
+        double planetMass = 0.0;
+    };
+
+    FrameSummary summarise(const SharedFrameView& view) {
+        FrameSummary s;
+        double sumX = 0.0, sumY = 0.0, sumV2 = 0.0;
+        for (int i = 0; i < view.particleCount; ++i) {
+            sumX += view.posX[i];
+            sumY += view.posY[i];
+            sumV2 += double(view.velX[i]) * view.velX[i] + double(view.velY[i]) * view.velY[i];
+        }
+        if (view.particleCount > 0) {
+            s.centerX = sumX / view.particleCount;
+            s.centerY = sumY / view.particleCount;
+            s.rmsSpeed = std::sqrt(sumV2 / view.particleCount);
+        }
+        for (int p = 0; p < view.planetCount; ++p) s.planetMass += view.planetMass[p];
+        return s;
+    }
+
+    // Retries until the writer has created the segment or the deadline passes
+    bool attach(SharedStateReader& reader, const char* name, Clock::time_point deadline) {
+        while (!reader.open(name, true)) {
+            if (Clock::now() > deadline) {
+                return reader.open(name);   // Once more, reporting why
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+        return true;
+    }
+}
+
+int main(int argc, char** argv) {
+    const char* name = "/particles";
+    int frames = 10;
+    double interval = 0.5, timeout = 10.0;
+
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (std::strcmp(arg, "--name") == 0 && hasValue) name = argv[++i];
+        else if (std::strcmp(arg, "--frames") == 0 && hasValue) frames = std::atoi(argv[++i]);
+        else if (std::strcmp(arg, "--interval") == 0 && hasValue) interval = std::strtod(argv[++i], nullptr);
+        else if (std::strcmp(arg, "--timeout") == 0 && hasValue) timeout = std::strtod(argv[++i], nullptr);
+        else {
+            printUsage();
+            return std::strcmp(arg, "--help") == 0 ? 0 : 1;
+        }
+    }
+
+    auto waitFor = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(timeout));
+    SharedStateReader reader;
+    if (!attach(reader, name, Clock::now() + waitFor)) return 1;
+
+    std::printf("%10s %10s %8s %10s %10s %10s %10s %7s %9s\n",
+                "frame", "asteroids", "planets", "center_x", "center_y", "rms_speed", "planet_m", "torn", "wait_ms");
+
+    uint64_t tornTotal = 0;
+    for (int read = 0; frames == 0 || read < frames; ++read) {
+        // 1. Ask for a frame and wait for the writer to finish one
+        Clock::time_point asked = Clock::now();
+        uint64_t before = reader.framesPublished();
+        reader.request();
+        while (reader.framesPublished() == before) {
+            if (reader.status() != SharedStatus::Live) break;
+            if (Clock::now() - asked > waitFor) {
+                std::cerr << "[SharedReader] No frame from the writer within " << timeout << " s" << std::endl;
+                return 1;
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+
+        // 2. The writer grew the segment or exited: follow it or stop
+        if (reader.status() == SharedStatus::Closed) {
+            std::cout << "[SharedReader] Writer exited after " << read << " frames" << std::endl;
+            break;
+        }
+        if (reader.status() == SharedStatus::Replaced) {
+            reader.close();
+            if (!attach(reader, name, Clock::now() + waitFor)) return 1;
+            --read;
+            continue;
+        }
+        double waitMs = std::chrono::duration<double, std::milli>(Clock::now() - asked).count();
+
+        // 3. Read in place, retry if the writer reused the slot meanwhile
+        SharedFrameView view;
+        FrameSummary summary;
+        int torn = 0;
+        while (true) {
+            if (reader.acquire(view)) {
+                summary = summarise(view);
+                if (reader.validate(view)) break;
+            }
+            torn++;
+        }
+        tornTotal += torn;
+
+        std::printf("%10llu %10d %8d %10.3f %10.3f %10.4f %10.1f %7d %9.2f\n",
+                    static_cast<unsigned long long>(view.frame), view.particleCount, view.planetCount,
+                    summary.centerX, summary.centerY, summary.rmsSpeed, summary.planetMass, torn, waitMs);
+        std::fflush(stdout);
+
+        std::this_thread::sleep_for(std::chrono::duration<double>(interval));
+    }
+
+    std::cout << "[SharedReader] " << tornTotal << " torn reads retried" << std::endl;
+    return 0;
+}
@@ -3,6 +3,7 @@
 #include <cstdint>
 
 #define KINEMATICS
+#define GRAVITY
 
 // Global Simulation Constants
 constexpr float SIM_WIDTH = 300.0f;
@@ -17,7 +18,9 @@ enum class BodyType {
 struct SimConfig {
     // --- System State ---
     bool paused = false;
+    float simSpeed = 1.0f;         // Simulated seconds per wall-clock second (0 = unthrottled)
     int particleCount = 4000;
+    uint32_t seed = 1;             // Seed for belt and planet generation
     
     // --- Global Forces ---
     bool enableGravity = false; 
@@ -29,17 +32,31 @@ struct SimConfig {
     float starMass = 10000.0f; 
     float starX = SIM_WIDTH / 2.0f;
     float starY = SIM_HEIGHT / 2.0f;
+    float starRadius = 3.0f;       // Accretion radius
     
     // --- Physics Properties ---
     float damping = 1.0f;       
     float restitution = 0.6f;   
     float collisionRadius = 0.3f; 
     bool enableCollisions = true;
+    bool parallelCollisions = true; // Deterministic cell-colored solver instead of one serial sweep
+    float verletSkin = 0.0f;        // > 0: reuse collision pair lists built with this margin
+                                    // until a body moves half of it (0 = new grid every substep)
+    bool enableAccretion = false;   // Remove asteroids that fall inside the star or a planet
     
     // --- Advanced Physics ---
     bool enableInterParticleGravity = false;
     float interParticleG = 0.05f; 
+    float barnesHutTheta = 0.5f;  // Opening angle (0 = exact, larger = faster)
     int substeps = 8;             
+    int workerThreads = 0;        // Threads for the particle passes (0 = all hardware threads)
+    int reorderInterval = 16;     // Steps between Z-order re-sorts of the particle arrays (0 = off)
+    bool blockTimesteps = false;  // KDK leapfrog with per-particle power-of-two steps inside a frame
+    float timestepAccuracy = 0.025f; // Block steps: dt <= accuracy * sqrt(1 / |a|). Steps never cross a
+                                     // planet's cutoff or surface, so at this value the worst errors
+                                     // match `substeps` fixed steps and the median is lower
+    bool compactStorage = false;  // 16-bit positions, half velocities; only used while collisions,
+                                  // self-gravity and accretion are off
 
     // --- Object Spawner Settings (Controlled by ImGui) ---
     int spawnType = 0; // 0 = Planet, 1 = Asteroid
@@ -54,4 +71,29 @@ struct SimConfig {
     bool spawnClick = false;
     float spawnX = 0.0f;
     float spawnY = 0.0f;
-};
\ No newline at end of file
+
+    // --- Trajectory Recording (toggle, not an event) ---
+    bool recordTrajectory = false;
+    char trajectoryPath[256] = "particles.traj";
+
+    // --- Checkpoint Events (Renderer writes, SimulationThread reads) ---
+    char checkpointPath[256] = "particles.ckpt";
+    bool saveCheckpoint = false;
+    bool loadCheckpoint = false;
+};
+
+// Every SimConfig field in declaration order. Checkpoints store SimConfig as
+// raw bytes tagged with a fingerprint of this list, so a field added above
+// must be added here too (checkpoint.cpp asserts the list covers the struct).
+#define SIM_CONFIG_FIELDS(X) \
+    X(paused) X(simSpeed) X(particleCount) X(seed) \
+    X(enableGravity) X(gravityX) X(gravityY) \
+    X(enableCentralGravity) X(starMass) X(starX) X(starY) X(starRadius) \
+    X(damping) X(restitution) X(collisionRadius) X(enableCollisions) X(parallelCollisions) \
+    X(verletSkin) X(enableAccretion) \
+    X(enableInterParticleGravity) X(interParticleG) X(barnesHutTheta) X(substeps) X(workerThreads) \
+    X(reorderInterval) X(blockTimesteps) X(timestepAccuracy) X(compactStorage) \
+    X(spawnType) X(spawnMass) X(spawnRadius) X(spawnColor) X(spawnAutoOrbit) X(spawnVelX) X(spawnVelY) \
+    X(spawnClick) X(spawnX) X(spawnY) \
+    X(recordTrajectory) X(trajectoryPath) \
+    X(checkpointPath) X(saveCheckpoint) X(loadCheckpoint)
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+
+// Philox4x32-10 counter-based generator (Salmon et al., "Parallel Random
+// Numbers: As Easy as 1, 2, 3", SC'11). Output is a pure function of
+// (counter, key): there is no state to share or advance, so any thread can
+// produce the numbers for any index, and a given seed gives the same values
+// on every machine and thread count.
+struct Philox4x32 {
+    uint32_t v[4];
+
+    // Four 32-bit outputs for one 128-bit counter under a 64-bit key
+    static Philox4x32 generate(uint32_t c0, uint32_t c1, uint32_t c2, uint32_t c3, uint32_t k0, uint32_t k1) {
+        const uint32_t M0 = 0xD2511F53u, M1 = 0xCD9E8D57u;
+        const uint32_t W0 = 0x9E3779B9u, W1 = 0xBB67AE85u;
+        for (int round = 0; round < 10; ++round) {
+            uint64_t p0 = static_cast<uint64_t>(M0) * c0;
+            uint64_t p1 = static_cast<uint64_t>(M1) * c2;
+            uint32_t n0 = static_cast<uint32_t>(p1 >> 32) ^ c1 ^ k0;
+            uint32_t n2 = static_cast<uint32_t>(p0 >> 32) ^ c3 ^ k1;
+            c1 = static_cast<uint32_t>(p1);
+            c3 = static_cast<uint32_t>(p0);
+            c0 = n0;
+            c2 = n2;
+            k0 += W0;
+            k1 += W1;
+        }
+        return Philox4x32{ { c0, c1, c2, c3 } };
+    }
+
+    // Uniform in [0, 1) from the top 24 bits of output word i
+    float uniform(int i) const {
+        return static_cast<float>(v[i] >> 8) * (1.0f / 16777216.0f);
+    }
+};